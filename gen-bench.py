@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+#
+# Copyright 2021-2022 Patrick Flynn
+# This file is part of the Tiny Lang compiler.
+# Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+#
+# Generates a large, valid program for benchmarking the frontend:
+#
+#   ./gen-bench.py --functions 5000 --depth 8 -o /tmp/big.tl
+#   build/src/tlc --bench=parse /tmp/big.tl
+#
+# build/src/tlc-bench runs the same benchmark, and also counts allocations.
+#
+# The output only depends on the options (and the seed), so the same command
+# gives the same input for comparing two builds. The program also compiles and
+# runs, so it can be used to time the rest of the compiler.
+#
+import argparse
+import random
+import sys
+
+parser = argparse.ArgumentParser(description="Generate a large Tiny Lang program")
+parser.add_argument("--functions", type=int, default=2000, help="number of functions")
+parser.add_argument("--depth", type=int, default=6, help="maximum depth of each expression")
+parser.add_argument("--structs", type=int, default=8, help="number of structures")
+parser.add_argument("--struct-size", type=int, default=64, help="members in each structure")
+parser.add_argument("--seed", type=int, default=1, help="random seed")
+parser.add_argument("-o", dest="output", default="-", help="output file (default stdout)")
+args = parser.parse_args()
+
+rand = random.Random(args.seed)
+out = []
+
+# No division, so nothing can trap at runtime
+OPS = ["+", "-", "*", "&", "|", "^"]
+
+def expression(names, depth):
+    if depth == 0 or rand.random() < 0.2:
+        if rand.random() < 0.3:
+            return str(rand.randint(0, 1000))
+        return rand.choice(names)
+
+    lval = expression(names, depth - 1)
+    rval = expression(names, depth - 1)
+    if rand.random() < 0.3:
+        return "(" + lval + " " + rand.choice(OPS) + " " + rval + ")"
+    return lval + " " + rand.choice(OPS) + " " + rval
+
+# The structures
+for i in range(args.structs):
+    out.append("struct Big%d is\n" % i)
+    for j in range(args.struct_size):
+        out.append("    m%d : i32 := %d;\n" % (j, j))
+    out.append("end\n\n")
+
+# The functions; each one can call the ones before it
+for i in range(args.functions):
+    names = ["a", "b", "x"]
+
+    out.append("# Function %d\n" % i)
+    out.append("func f%d(a : i32, b : i32) -> i32 is\n" % i)
+    out.append("    var x : i32 := %s;\n" % expression(["a", "b"], args.depth))
+    out.append("    var y : i32 := %s;\n" % expression(names, args.depth))
+    names.append("y")
+
+    if args.structs > 0 and args.struct_size > 0:
+        member = "m%d" % rand.randrange(args.struct_size)
+        out.append("    struct s : Big%d;\n" % rand.randrange(args.structs))
+        out.append("    s.%s := %s;\n" % (member, expression(names, args.depth // 2)))
+        out.append("    y := y + s.%s;\n" % member)
+
+    out.append("    var values : i32[4];\n")
+    out.append("    values[%d] := %s;\n" % (rand.randrange(4), expression(names, args.depth // 2)))
+
+    out.append("    if x > y then\n")
+    out.append("        x := %s;\n" % expression(names, args.depth // 2))
+    out.append("    elif x = y then\n")
+    out.append("        println(\"f%d: equal\");\n" % i)
+    out.append("    else\n")
+    out.append("        y := %s;\n" % expression(names, args.depth // 2))
+    out.append("    end\n")
+
+    out.append("    var count : i32 := 0;\n")
+    out.append("    while count < %d do\n" % rand.randint(1, 4))
+    out.append("        x := x + count * %d;\n" % rand.randint(1, 100))
+    out.append("        count := count + 1;\n")
+    out.append("    end\n")
+
+    if i > 0:
+        out.append("    y := y + f%d(x, %d);\n" % (rand.randrange(max(0, i - 10), i), rand.randint(0, 100)))
+
+    out.append("    return %s;\n" % expression(names, args.depth // 2))
+    out.append("end\n\n")
+
+# The entry point calls the last few functions, which call a chain of the rest
+out.append("func main -> i32 is\n")
+out.append("    var result : i32 := 0;\n")
+for i in range(max(0, args.functions - 5), args.functions):
+    out.append("    result := result ^ f%d(%d, %d);\n" % (i, rand.randint(0, 100), rand.randint(0, 100)))
+out.append("    println(\"%d\", result);\n")
+out.append("    return 0;\n")
+out.append("end\n")
+
+if args.output == "-":
+    sys.stdout.write("".join(out))
+else:
+    with open(args.output, "w") as f:
+        f.write("".join(out))
@@ -19,8 +19,20 @@ function gen_test() {
     	echo $? > $1/out/$name.code
     	
     	rm ./$name
-    	rm /tmp/$name.o
-    	rm /tmp/$name.asm
+    	
+    	test_count=$((test_count+1))
+    done
+}
+
+function gen_error_test() {
+    mkdir -p $1/out
+    
+    for entry in $1/*.tl
+    do
+    	name=`basename $entry .tl`
+    	
+    	$TLC $entry -o $name > $1/out/$name.out 2>&1
+    	echo $? > $1/out/$name.code
     	
     	test_count=$((test_count+1))
     done
@@ -45,6 +57,11 @@ gen_test 'test/array'
 gen_test 'test/func'
 gen_test 'test/str'
 gen_test 'test/struct'
+gen_test 'test/scope'
+
+gen_error_test 'test/syntax/error'
+gen_error_test 'test/scope/error'
+gen_error_test 'test/struct/error'
 
 echo ""
 echo "$test_count generated successfully."
@@ -18,6 +18,11 @@ sudo cp build/lib/libtinylang.so /usr/lib
 
 sudo cp -r lib/include/* $INCLUDE_INSTALL
 
+# Precompile the headers, so imports don't have to parse them
+for header in $INCLUDE_INSTALL/std/*.th ; do
+    sudo build/src/tlc --emit-module $header
+done
+
 sudo ldconfig
 
 echo "Done"
@@ -16,6 +16,7 @@ fi
 ./install-stdlib.sh
 
 install ./build/src/tlc /usr/local/bin/tlc
+install ./build/src/tlcc /usr/local/bin/tlcc
 
 echo "Done"
 
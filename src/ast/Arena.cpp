@@ -0,0 +1,92 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#include <cstdlib>
+#include <new>
+#include <iterator>
+
+#include <ast/Arena.hpp>
+#include <ast/ast.hpp>
+
+static const size_t CHUNK_SIZE = 64 * 1024;
+static const size_t ALIGN = alignof(std::max_align_t);
+
+// Each unit is parsed on a single thread
+static thread_local AstArena *current = nullptr;
+
+AstArena::~AstArena() {
+    for (auto node = nodes.rbegin(); node != nodes.rend(); node++) {
+        (*node)->~AstNode();
+    }
+    
+    for (char *chunk : chunks) free(chunk);
+}
+
+void *AstArena::allocate(size_t size) {
+    size = (size + ALIGN - 1) & ~(ALIGN - 1);
+    
+    if (size > (size_t)(end - next)) {
+        // Something too big to share a chunk gets one of its own, so the
+        // current chunk can keep filling up
+        if (size > CHUNK_SIZE / 4) {
+            char *chunk = (char *)malloc(size);
+            if (chunk == nullptr) throw std::bad_alloc();
+            chunks.push_back(chunk);
+            nodes.push_back((AstNode *)chunk);
+            used += size;
+            return chunk;
+        }
+        
+        char *chunk = (char *)malloc(CHUNK_SIZE);
+        if (chunk == nullptr) throw std::bad_alloc();
+        chunks.push_back(chunk);
+        next = chunk;
+        end = next + CHUNK_SIZE;
+    }
+    
+    char *ptr = next;
+    next += size;
+    used += size;
+    nodes.push_back((AstNode *)ptr);
+    return ptr;
+}
+
+// A node is registered before its constructor runs, so if the constructor
+// throws, it has to come off again. Only the nodes that constructor built
+// itself (AstFunction makes its block) can come after it.
+void AstArena::release(void *ptr) {
+    for (auto node = nodes.rbegin(); node != nodes.rend(); node++) {
+        if (*node != (AstNode *)ptr) continue;
+        nodes.erase(std::next(node).base());
+        return;
+    }
+}
+
+AstArena *AstArena::getCurrent() {
+    return current;
+}
+
+AstArena::Scope::Scope(AstArena *arena) {
+    previous = current;
+    current = arena;
+}
+
+AstArena::Scope::~Scope() {
+    current = previous;
+}
+
+//
+// The node allocator
+//
+void *AstNode::operator new(size_t size) {
+    if (current) return current->allocate(size);
+    return ::operator new(size);
+}
+
+// Nodes go with their arena (or live forever, if there wasn't one). This is
+// only called when a constructor throws, which leaves the node unbuilt.
+void AstNode::operator delete(void *ptr) {
+    if (current) current->release(ptr);
+}
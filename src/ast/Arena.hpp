@@ -0,0 +1,76 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+
+#include <lex/Symbol.hpp>
+
+class AstNode;
+class AstDataType;
+class AstPointerType;
+class AstStructType;
+
+//
+// The AST arena
+// Every node and data type is bump-allocated out of the arena that is current
+// on the thread when it is created (AstNode has its own operator new), so
+// building a node is a pointer bump, and freeing a whole tree is one pass over
+// a few large chunks. Names don't need to live here; they are symbols.
+//
+// The parser makes its tree's arena current while it builds, and the compiler
+// does the same for the few types it builds. A node created with no current
+// arena falls back to the heap, and is never freed.
+//
+// Nodes can't be deleted one at a time; they all go when the arena does. Since
+// header nodes are shared between trees, a tree holds on to the arenas of the
+// headers it imports (and a cached header to its own), which is why they are
+// shared.
+//
+// The arena also keeps the canonical pointer and structure types of whatever is
+// built in it (see ast_builder.cpp), so they go away with the tree too.
+//
+class AstArena {
+public:
+    AstArena() {}
+    ~AstArena();
+    
+    AstArena(const AstArena &) = delete;
+    AstArena &operator=(const AstArena &) = delete;
+    
+    // Memory for a node; the node is destroyed with the arena
+    void *allocate(size_t size);
+    
+    // Forgets a node whose constructor threw, so it isn't destroyed
+    void release(void *ptr);
+    
+    // The number of bytes handed out
+    size_t getSize() { return used; }
+    
+    static AstArena *getCurrent();
+    
+    // The canonical types built in this arena; only ever used by the thread
+    // building the tree
+    std::unordered_map<AstDataType *, AstPointerType *> pointerTypes;
+    std::unordered_map<Symbol, AstStructType *> structTypes;
+    
+    // Makes an arena current on this thread until the end of the C++ scope
+    class Scope {
+    public:
+        explicit Scope(AstArena *arena);
+        ~Scope();
+    private:
+        AstArena *previous;
+    };
+private:
+    std::vector<char *> chunks;
+    std::vector<AstNode *> nodes;       // To run the destructors
+    char *next = nullptr;
+    char *end = nullptr;
+    size_t used = 0;
+};
@@ -16,9 +16,6 @@ class AstExpression : public AstNode {
 public:
     explicit AstExpression() : AstNode(V_AstType::None) {}
     explicit AstExpression(V_AstType type) : AstNode(type) {}
-    
-    virtual void print() {}
-    virtual std::string dot(std::string parent) { return ""; }
 };
 
 // Holds a list of expressions
@@ -27,10 +24,7 @@ public:
     AstExprList() : AstExpression(V_AstType::ExprList) {}
     
     void addExpression(AstExpression *expr) { list.push_back(expr); }
-    std::vector<AstExpression *> getList() { return list; }
-    
-    void print();
-    std::string dot(std::string parent) override;
+    const std::vector<AstExpression *> &getList() { return list; }
 private:
     std::vector<AstExpression *> list;
 };
@@ -39,9 +33,6 @@ private:
 class AstOp : public AstExpression {
 public:
     bool isBinaryOp() { return isBinary; }
-
-    virtual void print() {}
-    virtual std::string dot(std::string parent) { return ""; }
 protected:
     bool isBinary = true;
 };
@@ -55,9 +46,6 @@ public:
 
     void setVal(AstExpression *val) { this->val = val; }
     AstExpression *getVal() { return val; }
-    
-    virtual void print() {}
-    virtual std::string dot(std::string parent) { return ""; }
 protected:
     AstExpression *val;
 };
@@ -68,9 +56,6 @@ public:
     AstNegOp() {
         this->type = V_AstType::Neg;
     }
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents the base of a binary expression
@@ -83,9 +68,6 @@ public:
     AstExpression *getLVal() { return lval; }
     AstExpression *getRVal() { return rval; }
     int getPrecedence() { return precedence; }
-    
-    virtual void print() {}
-    virtual std::string dot(std::string parent) { return ""; }
 protected:
     AstExpression *lval, *rval;
     int precedence = 0;
@@ -105,9 +87,6 @@ public:
         this->lval = lval;
         this->rval = rval;
     }
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents an add operation
@@ -117,9 +96,6 @@ public:
         this->type = V_AstType::Add;
         this->precedence = 4;
     }
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents a subtraction operation
@@ -129,9 +105,6 @@ public:
         this->type = V_AstType::Sub;
         this->precedence = 4;
     }
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents a multiplication operation
@@ -141,9 +114,6 @@ public:
         this->type = V_AstType::Mul;
         this->precedence = 3;
     }
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents a division operation
@@ -153,9 +123,6 @@ public:
         this->type = V_AstType::Div;
         this->precedence = 3;
     }
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents the modulus operation
@@ -165,9 +132,6 @@ public:
         this->type = V_AstType::Mod;
         this->precedence = 3;
     }
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents a division operation
@@ -177,9 +141,6 @@ public:
         this->type = V_AstType::And;
         this->precedence = 8;
     }
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents an or operation
@@ -189,9 +150,6 @@ public:
         this->type = V_AstType::Or;
         this->precedence = 10;
     }
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents a xor operation
@@ -201,9 +159,6 @@ public:
         this->type = V_AstType::Xor;
         this->precedence = 9;
     }
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents an equal-to operation
@@ -213,9 +168,6 @@ public:
         this->type = V_AstType::EQ;
         this->precedence = 6;
     }
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents a not-equal-to operation
@@ -225,9 +177,6 @@ public:
         this->type = V_AstType::NEQ;
         this->precedence = 6;
     }
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents a greater-than operation
@@ -237,9 +186,6 @@ public:
         this->type = V_AstType::GT;
         this->precedence = 6;
     }
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents a less-than operation
@@ -249,9 +195,6 @@ public:
         this->type = V_AstType::LT;
         this->precedence = 6;
     }
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents a greater-than-or-equal operation
@@ -261,9 +204,6 @@ public:
         this->type = V_AstType::GTE;
         this->precedence = 6;
     }
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents a less-than-or-equal operation
@@ -273,9 +213,6 @@ public:
         this->type = V_AstType::LTE;
         this->precedence = 6;
     }
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents a logical AND operation
@@ -285,9 +222,6 @@ public:
         this->type = V_AstType::LogicalAnd;
         this->precedence = 11;
     }
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents a logical OR operation
@@ -297,9 +231,6 @@ public:
         this->type = V_AstType::LogicalOr;
         this->precedence = 12;
     }
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents a character literal
@@ -310,8 +241,6 @@ public:
     }
     
     char getValue() { return val; }
-    void print();
-    std::string dot(std::string parent) override;
 private:
     char val = 0;
 };
@@ -325,7 +254,6 @@ public:
     }
     
     uint8_t getValue() { return val; }
-    void print();
 private:
     uint8_t val = 0;
 };
@@ -339,7 +267,6 @@ public:
     }
     
     uint16_t getValue() { return val; }
-    void print();
 private:
     uint16_t val = 0;
 };
@@ -355,8 +282,6 @@ public:
     void setValue(uint64_t val) { this->val = val; }
     
     uint64_t getValue() { return val; }
-    void print();
-    std::string dot(std::string parent) override;
 private:
     uint64_t val = 0;
 };
@@ -370,7 +295,6 @@ public:
     }
     
     uint64_t getValue() { return val; }
-    void print();
 private:
     uint64_t val = 0;
 };
@@ -378,83 +302,70 @@ private:
 // Represents a string literal
 class AstString : public AstExpression {
 public:
-    explicit AstString(std::string val) : AstExpression(V_AstType::StringL) {
+    explicit AstString(Symbol val) : AstExpression(V_AstType::StringL) {
         this->val = val;
     }
     
-    std::string getValue() { return val; }
-    void print();
-    std::string dot(std::string parent) override;
+    Symbol getValue() { return val; }
 private:
-    std::string val = "";
+    Symbol val;
 };
 
 // Represents a variable reference
 class AstID: public AstExpression {
 public:
-    explicit AstID(std::string val) : AstExpression(V_AstType::ID) {
+    explicit AstID(Symbol val) : AstExpression(V_AstType::ID) {
         this->val = val;
     }
     
-    std::string getValue() { return val; }
-    void print();
-    std::string dot(std::string parent) override;
+    Symbol getValue() { return val; }
 private:
-    std::string val = "";
+    Symbol val;
 };
 
 // Represents an array access
 class AstArrayAccess : public AstExpression {
 public:
-    explicit AstArrayAccess(std::string val) : AstExpression(V_AstType::ArrayAccess) {
+    explicit AstArrayAccess(Symbol val) : AstExpression(V_AstType::ArrayAccess) {
         this->val = val;
     }
     
     void setIndex(AstExpression *index) { this->index = index; }
     
-    std::string getValue() { return val; }
+    Symbol getValue() { return val; }
     AstExpression *getIndex() { return index; }
-    
-    void print();
-    std::string dot(std::string parent) override;
 private:
-    std::string val = "";
+    Symbol val;
     AstExpression *index;
 };
 
 // Represents a structure access
 class AstStructAccess : public AstExpression {
 public:
-    explicit AstStructAccess(std::string var, std::string member) : AstExpression(V_AstType::StructAccess) {
+    explicit AstStructAccess(Symbol var, Symbol member) : AstExpression(V_AstType::StructAccess) {
         this->var = var;
         this->member = member;
     }
 
-    std::string getName() { return var; }
-    std::string getMember() { return member; }
-
-    void print();
-    std::string dot(std::string parent) override;
+    Symbol getName() { return var; }
+    Symbol getMember() { return member; }
 private:
-    std::string var = "";
-    std::string member = "";
+    Symbol var;
+    Symbol member;
 };
 
 // Represents a function call
 class AstFuncCallExpr : public AstExpression {
 public:
-    explicit AstFuncCallExpr(std::string name) : AstExpression(V_AstType::FuncCallExpr) {
+    explicit AstFuncCallExpr(Symbol name) : AstExpression(V_AstType::FuncCallExpr) {
         this->name = name;
     }
     
     void setArgExpression(AstExpression *expr) { this->expr = expr; }
     AstExpression *getArgExpression() { return expr; }
-    std::string getName() { return name; }
-    
-    void print();
-    std::string dot(std::string parent) override;
+    Symbol getName() { return name; }
 private:
     AstExpression *expr;
-    std::string name = "";
+    Symbol name;
 };
 
@@ -0,0 +1,185 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#include <unordered_map>
+
+#include <ast/FlatAst.hpp>
+#include <ast/Visitor.hpp>
+
+//
+// Builds the flat form with the pointer tree's own walker, so it has the same
+// children in the same order. The children of the open nodes are collected on
+// one stack, and each node's run is copied into the child list when it is left.
+//
+// Only data types are looked up to be stored once; they are what trees share
+// everywhere, and the data types come last in V_AstType.
+//
+class AstFlattener : public AstVisitor {
+public:
+    explicit AstFlattener(FlatAst *flat) {
+        this->flat = flat;
+    }
+    
+    void flatten(AstTree *tree) {
+        flat->nodes.push_back(FlatNode());
+        open.push_back({ 0, 0 });
+        walk(tree);
+        close();
+    }
+protected:
+    bool visit(AstNode *node) override {
+        bool isType = node->getType() >= V_AstType::Void;
+        if (isType) {
+            auto entry = types.find(node);
+            if (entry != types.end()) {
+                pending.push_back(entry->second);
+                return false;
+            }
+        }
+        
+        uint32_t index = flat->nodes.size();
+        if (isType) types[node] = index;
+        pending.push_back(index);
+        flat->nodes.push_back(buildNode(node));
+        open.push_back({ index, pending.size() });
+        return true;
+    }
+    
+    void leave(AstNode *) override {
+        close();
+    }
+    
+    void visitEmpty() override {
+        pending.push_back(FlatAst::None);
+    }
+private:
+    struct OpenNode {
+        uint32_t index;
+        size_t start;       // Where its children start in pending
+    };
+    
+    FlatAst *flat;
+    std::unordered_map<AstNode *, uint32_t> types;
+    std::vector<uint32_t> pending;
+    std::vector<OpenNode> open;
+    
+    void close() {
+        OpenNode node = open.back();
+        open.pop_back();
+        
+        FlatNode &flatNode = flat->nodes[node.index];
+        flatNode.firstChild = flat->children.size();
+        flatNode.childCount = pending.size() - node.start;
+        flat->children.insert(flat->children.end(), pending.begin() + node.start, pending.end());
+        pending.resize(node.start);
+    }
+    
+    uint32_t addSymbol(Symbol symbol) {
+        flat->symbols.push_back(symbol);
+        return flat->symbols.size() - 1;
+    }
+    
+    uint32_t addValue(uint64_t value) {
+        flat->values.push_back(value);
+        return flat->values.size() - 1;
+    }
+    
+    uint32_t addSymbols(Symbol name, const std::vector<Var> &vars) {
+        uint32_t first = addSymbol(name);
+        for (const Var &var : vars) addSymbol(var.name);
+        return first;
+    }
+    
+    FlatNode buildNode(AstNode *node) {
+        FlatNode flatNode;
+        flatNode.type = node->getType();
+        
+        switch (node->getType()) {
+            case V_AstType::ExternFunc: {
+                AstExternFunction *func = static_cast<AstExternFunction *>(node);
+                flatNode.data = addSymbols(func->getName(), func->getArguments());
+                if (func->isVarArgs()) flatNode.data |= FlatNode::FLAG;
+            } break;
+            
+            case V_AstType::Func: {
+                AstFunction *func = static_cast<AstFunction *>(node);
+                flatNode.data = addSymbols(func->getName(), func->getArguments());
+            } break;
+            
+            case V_AstType::StructDef: {
+                AstStruct *str = static_cast<AstStruct *>(node);
+                flatNode.data = addSymbols(str->getName(), str->getItems());
+            } break;
+            
+            case V_AstType::VarDec: flatNode.data = addSymbol(static_cast<AstVarDec *>(node)->getName()); break;
+            case V_AstType::FuncCallStmt: flatNode.data = addSymbol(static_cast<AstFuncCallStmt *>(node)->getName()); break;
+            
+            case V_AstType::StructDec: {
+                AstStructDec *dec = static_cast<AstStructDec *>(node);
+                flatNode.data = addSymbol(dec->getVarName());
+                addSymbol(dec->getStructName());
+                if (dec->isNoInit()) flatNode.data |= FlatNode::FLAG;
+            } break;
+            
+            case V_AstType::CharL: flatNode.data = addValue(static_cast<AstChar *>(node)->getValue()); break;
+            case V_AstType::I8L: flatNode.data = addValue(static_cast<AstI8 *>(node)->getValue()); break;
+            case V_AstType::I16L: flatNode.data = addValue(static_cast<AstI16 *>(node)->getValue()); break;
+            case V_AstType::I32L: flatNode.data = addValue(static_cast<AstI32 *>(node)->getValue()); break;
+            case V_AstType::I64L: flatNode.data = addValue(static_cast<AstI64 *>(node)->getValue()); break;
+            
+            case V_AstType::StringL: flatNode.data = addSymbol(static_cast<AstString *>(node)->getValue()); break;
+            case V_AstType::ID: flatNode.data = addSymbol(static_cast<AstID *>(node)->getValue()); break;
+            case V_AstType::ArrayAccess: flatNode.data = addSymbol(static_cast<AstArrayAccess *>(node)->getValue()); break;
+            case V_AstType::FuncCallExpr: flatNode.data = addSymbol(static_cast<AstFuncCallExpr *>(node)->getName()); break;
+            
+            case V_AstType::StructAccess: {
+                AstStructAccess *sa = static_cast<AstStructAccess *>(node);
+                flatNode.data = addSymbol(sa->getName());
+                addSymbol(sa->getMember());
+            } break;
+            
+            case V_AstType::Int8:
+            case V_AstType::Int16:
+            case V_AstType::Int32:
+            case V_AstType::Int64: {
+                if (static_cast<AstDataType *>(node)->isUnsigned()) flatNode.data = FlatNode::FLAG;
+            } break;
+            
+            case V_AstType::Struct: flatNode.data = addSymbol(static_cast<AstStructType *>(node)->getName()); break;
+            
+            default: {}
+        }
+        
+        return flatNode;
+    }
+};
+
+FlatAst::FlatAst(AstTree *tree) {
+    AstFlattener flattener(this);
+    flattener.flatten(tree);
+}
+
+size_t FlatAst::getBytes() const {
+    return nodes.capacity() * sizeof(FlatNode) + children.capacity() * sizeof(uint32_t)
+        + symbols.capacity() * sizeof(Symbol) + values.capacity() * sizeof(uint64_t);
+}
+
+void FlatAstVisitor::walk(const FlatAst &flat) {
+    const FlatNode &root = flat.getNode(0);
+    for (uint32_t i = 0; i<root.childCount; i++) {
+        walk(flat, flat.getChild(0, i));
+    }
+}
+
+void FlatAstVisitor::walk(const FlatAst &flat, uint32_t index) {
+    if (index == FlatAst::None || !visit(flat, index)) return;
+    
+    const FlatNode &node = flat.getNode(index);
+    for (uint32_t i = 0; i<node.childCount; i++) {
+        walk(flat, flat.getChild(index, i));
+    }
+    
+    leave(flat, index);
+}
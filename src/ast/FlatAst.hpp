@@ -0,0 +1,103 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include <ast/ast.hpp>
+
+//
+// The flat form of a tree
+// An alternative to the pointer tree for passes that only read it. Every node is
+// a 16-byte record in one array, in the order the AstVisitor walk first reaches
+// it, and refers to its children by 32-bit index into that array. A node's
+// children are one contiguous run of the child list, in the walker's order, with
+// None where a child can be missing (see AstVisitor::visitEmpty). Names and
+// literal values live in their own arrays, so there isn't a pointer in it.
+//
+// Data types are stored once, and each node that uses one refers to the same
+// index, just as in the pointer tree. The odd expression that the pointer tree
+// shares (an array declaration's size, across its names) is copied instead; the
+// walk reaches it once per use either way. Node 0 is the root: its children are
+// the structures, then the global statements.
+//
+// What a node's data holds depends on its type:
+//   Func, ExternFunc, StructDef    the name, then each argument or member name
+//   VarDec, FuncCallStmt, StringL,
+//   ID, ArrayAccess, FuncCallExpr,
+//   Struct                         one name
+//   StructDec, StructAccess        two names (variable and structure or member)
+//   CharL, I8L ... I64L            one value
+// The flag is varargs on an ExternFunc, no-init on a StructDec, and unsigned on
+// the integer types.
+//
+struct FlatNode {
+    V_AstType type = V_AstType::None;
+    uint32_t data = 0;              // The flag, and an index into the names or values
+    uint32_t firstChild = 0;        // Index into the child list
+    uint32_t childCount = 0;
+    
+    static constexpr uint32_t FLAG = 1u << 31;
+    
+    uint32_t getData() const { return data & ~FLAG; }
+    bool getFlag() const { return data & FLAG; }
+};
+
+class FlatAst {
+public:
+    static constexpr uint32_t None = UINT32_MAX;
+    
+    // Flattens a finished tree; the tree can be changed or freed afterwards
+    explicit FlatAst(AstTree *tree);
+    
+    uint32_t size() const { return nodes.size(); }
+    const FlatNode &getNode(uint32_t index) const { return nodes[index]; }
+    
+    // The nth child of a node, which may be None
+    uint32_t getChild(uint32_t index, uint32_t n) const {
+        return children[nodes[index].firstChild + n];
+    }
+    
+    // The nth name, or the value, in a node's data
+    Symbol getSymbol(uint32_t index, uint32_t n = 0) const {
+        return symbols[nodes[index].getData() + n];
+    }
+    uint64_t getValue(uint32_t index) const {
+        return values[nodes[index].getData()];
+    }
+    
+    // What the arrays take up
+    size_t getBytes() const;
+private:
+    friend class AstFlattener;
+    
+    std::vector<FlatNode> nodes;
+    std::vector<uint32_t> children;
+    std::vector<Symbol> symbols;
+    std::vector<uint64_t> values;
+};
+
+//
+// A walk over the flat form
+// The same depth-first walk as AstVisitor, over indices instead of pointers.
+// The root isn't visited, only what it holds. Missing children are skipped, and
+// a shared node is reached once per use.
+//
+class FlatAstVisitor {
+public:
+    virtual ~FlatAstVisitor() {}
+    
+    void walk(const FlatAst &flat);
+    void walk(const FlatAst &flat, uint32_t index);
+protected:
+    // Called on the way down; returning false skips the node's children
+    virtual bool visit(const FlatAst &, uint32_t) { return true; }
+    
+    // Called on the way back up, if the children were walked
+    virtual void leave(const FlatAst &, uint32_t) {}
+};
@@ -17,15 +17,12 @@ class AstGlobalStatement : public AstNode {
 public:
     explicit AstGlobalStatement() : AstNode(V_AstType::None) {}
     explicit AstGlobalStatement(V_AstType type) : AstNode(type) {}
-    
-    virtual void print() {}
-    virtual std::string dot(std::string parent) { return ""; }
 };
 
 // Represents an extern function
 class AstExternFunction : public AstGlobalStatement {
 public:
-    explicit AstExternFunction(std::string name) : AstGlobalStatement(V_AstType::ExternFunc) {
+    explicit AstExternFunction(Symbol name) : AstGlobalStatement(V_AstType::ExternFunc) {
         this->name = name;
     }
     
@@ -39,14 +36,11 @@ public:
     void setVarArgs() { this->varargs = true; }
     bool isVarArgs() { return this->varargs; }
     
-    std::string getName() { return name; }
+    Symbol getName() { return name; }
     AstDataType *getDataType() { return dataType; }
-    std::vector<Var> getArguments() { return args; }
-    
-    void print() override;
-    std::string dot(std::string parent) override;
+    const std::vector<Var> &getArguments() { return args; }
 private:
-    std::string name = "";
+    Symbol name;
     std::vector<Var> args;
     AstDataType *dataType;
     bool varargs = false;
@@ -55,17 +49,17 @@ private:
 // Represents a function
 class AstFunction : public AstGlobalStatement {
 public:
-    explicit AstFunction(std::string name) : AstGlobalStatement(V_AstType::Func) {
+    explicit AstFunction(Symbol name) : AstGlobalStatement(V_AstType::Func) {
         this->name = name;
         block = new AstBlock;
     }
     
-    std::string getName() { return name; }
+    Symbol getName() { return name; }
     AstDataType *getDataType() { return dataType; }
-    std::vector<Var> getArguments() { return args; }
+    const std::vector<Var> &getArguments() { return args; }
     AstBlock *getBlock() { return block; }
     
-    void setName(std::string name) { this->name = name; }
+    void setName(Symbol name) { this->name = name; }
     
     void setArguments(std::vector<Var> args) { this->args = args; }
     
@@ -76,11 +70,8 @@ public:
     void setDataType(AstDataType *dataType) {
         this->dataType = dataType;
     }
-    
-    void print() override;
-    std::string dot(std::string parent) override;
 private:
-    std::string name = "";
+    Symbol name;
     std::vector<Var> args;
     AstBlock *block;
     AstDataType *dataType;
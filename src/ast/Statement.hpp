@@ -24,9 +24,6 @@ public:
     void setExpression(AstExpression *expr) { this->expr = expr; }
     AstExpression *getExpression() { return expr; }
     bool hasExpression() { return expr != nullptr; }
-    
-    virtual void print() {}
-    virtual std::string dot(std::string parent) { return ""; }
 private:
     AstExpression *expr = nullptr;
 };
@@ -42,40 +39,32 @@ public:
     }
     
     AstDataType *getDataType() { return dataType; }
-    
-    void print();
-    std::string dot(std::string parent) override;
 private:
-    AstDataType *dataType;
+    AstDataType *dataType = nullptr;
 };
 
 // Represents a function call statement
 class AstFuncCallStmt : public AstStatement {
 public:
-    explicit AstFuncCallStmt(std::string name) : AstStatement(V_AstType::FuncCallStmt) {
+    explicit AstFuncCallStmt(Symbol name) : AstStatement(V_AstType::FuncCallStmt) {
         this->name = name;
     }
     
-    std::string getName() { return name; }
-    void print();
-    std::string dot(std::string parent) override;
+    Symbol getName() { return name; }
 private:
-    std::string name = "";
+    Symbol name;
 };
 
 // Represents a return statement
 class AstReturnStmt : public AstStatement {
 public:
     explicit AstReturnStmt() : AstStatement(V_AstType::Return) {}
-    
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents a variable declaration
 class AstVarDec : public AstStatement {
 public:
-    explicit AstVarDec(std::string name, AstDataType *dataType) : AstStatement(V_AstType::VarDec) {
+    explicit AstVarDec(Symbol name, AstDataType *dataType) : AstStatement(V_AstType::VarDec) {
         this->name = name;
         this->dataType = dataType;
     }
@@ -83,14 +72,11 @@ public:
     void setDataType(AstDataType *dataType) { this->dataType = dataType; }
     void setPtrSize(AstExpression *size) { this->size = size; }
     
-    std::string getName() { return name; }
+    Symbol getName() { return name; }
     AstDataType *getDataType() { return dataType; }
     AstExpression *getPtrSize() { return size; }
-    
-    void print();
-    std::string dot(std::string parent) override;
 private:
-    std::string name = "";
+    Symbol name;
     AstExpression *size = nullptr;
     AstDataType *dataType;
 };
@@ -98,22 +84,19 @@ private:
 // Represents a structure declaration
 class AstStructDec : public AstStatement {
 public:
-    explicit AstStructDec(std::string varName, std::string structName) : AstStatement(V_AstType::StructDec) {
+    explicit AstStructDec(Symbol varName, Symbol structName) : AstStatement(V_AstType::StructDec) {
         this->varName = varName;
         this->structName = structName;
     }
     
     void setNoInit(bool init) { noInit = init; }
     
-    std::string getVarName() { return varName; }
-    std::string getStructName() { return structName; }
+    Symbol getVarName() { return varName; }
+    Symbol getStructName() { return structName; }
     bool isNoInit() { return noInit; }
-    
-    void print();
-    std::string dot(std::string parent) override;
 private:
-    std::string varName = "";
-    std::string structName = "";
+    Symbol varName;
+    Symbol structName;
     bool noInit = false;
 };
 
@@ -127,9 +110,6 @@ public:
     
     AstBlock *getTrueBlock() { return trueBlock; }
     AstBlock *getFalseBlock() { return falseBlock; }
-    
-    void print(int indent);
-    std::string dot(std::string parent) override;
 private:
     AstBlock *trueBlock = nullptr;
     AstBlock *falseBlock = nullptr;
@@ -142,9 +122,6 @@ public:
     
     void setBlock(AstBlock *block) { this->block = block; }
     AstBlock *getBlock() { return block; }
-    
-    void print(int indent = 0);
-    std::string dot(std::string parent) override;
 private:
     AstBlock *block = nullptr;
 };
@@ -153,15 +130,11 @@ private:
 class AstBreak : public AstStatement {
 public:
     explicit AstBreak() : AstStatement(V_AstType::Break) {}
-    void print();
-    std::string dot(std::string parent) override;
 };
 
 // Represents a continue statement for a loop
 class AstContinue : public AstStatement {
 public:
     explicit AstContinue() : AstStatement(V_AstType::Continue) {}
-    void print();
-    std::string dot(std::string parent) override;
 };
 
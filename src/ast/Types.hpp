@@ -7,6 +7,9 @@
 
 #include <string>
 #include <map>
+#include <unordered_map>
+
+#include <lex/Symbol.hpp>
 
 //
 // Contains the variants for all AST nodes
@@ -96,10 +99,13 @@ public:
     explicit AstNode(V_AstType type) {
         this->type = type;
     }
+    virtual ~AstNode() {}
     
-    V_AstType getType() { return type; }
+    // Nodes are allocated from the current arena (see Arena.hpp)
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr);
     
-    virtual void print() {}
+    V_AstType getType() { return type; }
 protected:
     V_AstType type = V_AstType::None;
 };
@@ -114,11 +120,7 @@ public:
         this->_isUnsigned = _isUnsigned;
     }
     
-    void setUnsigned(bool _isUnsigned) { this->_isUnsigned = _isUnsigned; }
-    
     bool isUnsigned() { return _isUnsigned; }
-    
-    void print() override;
 protected:
     bool _isUnsigned = false;
 };
@@ -131,8 +133,6 @@ public:
     }
     
     AstDataType *getBaseType() { return baseType; }
-    
-    void print() override;
 protected:
     AstDataType *baseType = nullptr;
 };
@@ -140,25 +140,23 @@ protected:
 // Represents a structure type
 class AstStructType : public AstDataType {
 public:
-    explicit AstStructType(std::string name) : AstDataType(V_AstType::Struct) {
+    explicit AstStructType(Symbol name) : AstDataType(V_AstType::Struct) {
         this->name = name;
     }
     
-    std::string getName() { return name; }
-    
-    void print() override;
+    Symbol getName() { return name; }
 protected:
-    std::string name = "";
+    Symbol name;
 };
 
 struct Var {
     explicit Var() {}
-    explicit Var(AstDataType *type, std::string name = "") {
+    explicit Var(AstDataType *type, Symbol name = Symbol()) {
         this->type = type;
         this->name = name;
     }
 
-    std::string name;
+    Symbol name;
     AstDataType *type;
 };
 
@@ -173,22 +171,32 @@ public:
 
     void addStatement(AstStatement *stmt) { block.push_back(stmt); }
     void addStatements(std::vector<AstStatement *> block) { this->block = block; }
-    std::vector<AstStatement *> getBlock() { return block; }
-    
-    void print(int indent = 4);
-    std::string dot(std::string parent);
+    const std::vector<AstStatement *> &getBlock() { return block; }
 private:
     std::vector<AstStatement *> block;
 };
 
+// A member of a struct, as it is laid out
+struct StructMember {
+    int index;
+    int offset;
+    AstDataType *type;
+};
+
 // Represents a struct
 class AstStruct : public AstNode {
 public:
-    explicit AstStruct(std::string name) : AstNode(V_AstType::StructDef) {
+    explicit AstStruct(Symbol name) : AstNode(V_AstType::StructDef) {
         this->name = name;
     }
     
     void addItem(Var var, AstExpression *defaultExpression) {
+        StructMember member;
+        member.index = items.size();
+        member.offset = size;
+        member.type = var.type;
+        members[var.name] = member;
+        
         items.push_back(var);
         defaultExpressions[var.name] = defaultExpression;
         
@@ -207,20 +215,25 @@ public:
         }
     }
     
-    std::string getName() { return name; }
-    std::vector<Var> getItems() { return items; }
+    Symbol getName() { return name; }
+    const std::vector<Var> &getItems() { return items; }
     int getSize() { return size; }
     
-    AstExpression *getDefaultExpression(std::string name) {
-        return defaultExpressions[name];
+    // Returns nullptr if there is no such member
+    StructMember *getMember(Symbol name) {
+        auto entry = members.find(name);
+        if (entry == members.end()) return nullptr;
+        return &entry->second;
     }
     
-    void print();
-    std::string dot(std::string parent);
+    AstExpression *getDefaultExpression(Symbol name) {
+        return defaultExpressions[name];
+    }
 private:
-    std::string name;
+    Symbol name;
     std::vector<Var> items;
-    std::map<std::string, AstExpression*> defaultExpressions;
+    std::unordered_map<Symbol, AstExpression*> defaultExpressions;
+    std::unordered_map<Symbol, StructMember> members;
     int size = 0;
 };
 
@@ -0,0 +1,142 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#include <ast/Visitor.hpp>
+
+void AstVisitor::walk(AstTree *tree) {
+    for (AstStruct *str : tree->getStructs()) walk(str);
+    for (AstGlobalStatement *global : tree->getGlobalStatements()) walk(global);
+}
+
+void AstVisitor::walk(AstNode *node) {
+    if (node == nullptr) {
+        visitEmpty();
+        return;
+    }
+    if (!visit(node)) return;
+    
+    switch (node->getType()) {
+        //
+        // Globals
+        //
+        case V_AstType::ExternFunc: {
+            AstExternFunction *func = static_cast<AstExternFunction *>(node);
+            walk(func->getDataType());
+            for (const Var &arg : func->getArguments()) walk(arg.type);
+        } break;
+        
+        case V_AstType::Func: {
+            AstFunction *func = static_cast<AstFunction *>(node);
+            walk(func->getDataType());
+            for (const Var &arg : func->getArguments()) walk(arg.type);
+            walk(func->getBlock());
+        } break;
+        
+        case V_AstType::StructDef: {
+            AstStruct *str = static_cast<AstStruct *>(node);
+            for (const Var &item : str->getItems()) {
+                walk(item.type);
+                walk(str->getDefaultExpression(item.name));
+            }
+        } break;
+        
+        case V_AstType::Block: {
+            AstBlock *block = static_cast<AstBlock *>(node);
+            for (AstStatement *stmt : block->getBlock()) walk(stmt);
+        } break;
+        
+        //
+        // Statements
+        // Every statement can have an expression; the walk goes there first
+        //
+        case V_AstType::ExprStmt: {
+            AstExprStatement *stmt = static_cast<AstExprStatement *>(node);
+            walk(stmt->getDataType());
+            walk(stmt->getExpression());
+        } break;
+        
+        case V_AstType::VarDec: {
+            AstVarDec *vd = static_cast<AstVarDec *>(node);
+            walk(vd->getDataType());
+            walk(vd->getPtrSize());
+            walk(vd->getExpression());
+        } break;
+        
+        case V_AstType::If: {
+            AstIfStmt *cond = static_cast<AstIfStmt *>(node);
+            walk(cond->getExpression());
+            walk(cond->getTrueBlock());
+            walk(cond->getFalseBlock());
+        } break;
+        
+        case V_AstType::While: {
+            AstWhileStmt *loop = static_cast<AstWhileStmt *>(node);
+            walk(loop->getExpression());
+            walk(loop->getBlock());
+        } break;
+        
+        case V_AstType::Return:
+        case V_AstType::FuncCallStmt:
+        case V_AstType::StructDec:
+        case V_AstType::Break:
+        case V_AstType::Continue: {
+            walk(static_cast<AstStatement *>(node)->getExpression());
+        } break;
+        
+        //
+        // Expressions
+        //
+        case V_AstType::ExprList: {
+            AstExprList *list = static_cast<AstExprList *>(node);
+            for (AstExpression *item : list->getList()) walk(item);
+        } break;
+        
+        case V_AstType::Neg: {
+            walk(static_cast<AstNegOp *>(node)->getVal());
+        } break;
+        
+        case V_AstType::Assign:
+        case V_AstType::Add:
+        case V_AstType::Sub:
+        case V_AstType::Mul:
+        case V_AstType::Div:
+        case V_AstType::Mod:
+        case V_AstType::And:
+        case V_AstType::Or:
+        case V_AstType::Xor:
+        case V_AstType::EQ:
+        case V_AstType::NEQ:
+        case V_AstType::GT:
+        case V_AstType::LT:
+        case V_AstType::GTE:
+        case V_AstType::LTE:
+        case V_AstType::LogicalAnd:
+        case V_AstType::LogicalOr: {
+            AstBinaryOp *op = static_cast<AstBinaryOp *>(node);
+            walk(op->getLVal());
+            walk(op->getRVal());
+        } break;
+        
+        case V_AstType::ArrayAccess: {
+            walk(static_cast<AstArrayAccess *>(node)->getIndex());
+        } break;
+        
+        case V_AstType::FuncCallExpr: {
+            walk(static_cast<AstFuncCallExpr *>(node)->getArgExpression());
+        } break;
+        
+        //
+        // Data types
+        //
+        case V_AstType::Ptr: {
+            walk(static_cast<AstPointerType *>(node)->getBaseType());
+        } break;
+        
+        // Literals, IDs, structure accesses, and the other types are leaves
+        default: {}
+    }
+    
+    leave(node);
+}
@@ -0,0 +1,34 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#pragma once
+
+#include <ast/ast.hpp>
+
+//
+// A generic walk over the tree
+// The walker is the one place that knows what the children of each kind of node
+// are, so a pass that only cares about a few kinds doesn't need its own switch
+// over all of them. The walk is depth first, in source order: the structures,
+// then the global statements. Data types are visited too, and since those (and
+// some expressions) are shared, a node can be reached more than once.
+//
+class AstVisitor {
+public:
+    virtual ~AstVisitor() {}
+    
+    void walk(AstTree *tree);
+    void walk(AstNode *node);
+protected:
+    // Called on the way down; returning false skips the node's children
+    virtual bool visit(AstNode *) { return true; }
+    
+    // Called on the way back up, if the children were walked
+    virtual void leave(AstNode *) {}
+    
+    // Called for a child that can be missing and is, such as an if statement
+    // with no else block, so each kind of node has its children in fixed places
+    virtual void visitEmpty() {}
+};
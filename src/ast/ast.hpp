@@ -7,7 +7,10 @@
 
 #include <string>
 #include <vector>
+#include <unordered_map>
+#include <memory>
 
+#include <ast/Arena.hpp>
 #include <ast/Types.hpp>
 #include <ast/Global.hpp>
 #include <ast/Statement.hpp>
@@ -22,24 +25,41 @@ class AstStruct;
 // Represents an AST tree
 class AstTree {
 public:
-    explicit AstTree(std::string file) { this-> file = file; }
+    explicit AstTree(std::string file) {
+        this-> file = file;
+        arena = std::make_shared<AstArena>();
+    }
+    
+    // Frees every node in the tree, unless a header still shares them
     ~AstTree() {}
     
     std::string getFile() { return file; }
     
-    std::vector<AstGlobalStatement *> getGlobalStatements() {
+    // Where the tree's own nodes come from
+    std::shared_ptr<AstArena> getArena() { return arena; }
+    
+    // Keeps the nodes of an imported header around as long as this tree
+    void keepArena(std::shared_ptr<AstArena> other) {
+        if (other) imported.push_back(other);
+    }
+    
+    const std::vector<AstGlobalStatement *> &getGlobalStatements() {
         return global_statements;
     }
     
-    std::vector<AstStruct *> getStructs() {
+    const std::vector<AstStruct *> &getStructs() {
         return structs;
     }
     
-    bool hasStruct(std::string name) {
-        for (AstStruct *s : structs) {
-            if (s->getName() == name) return true;
-        }
-        return false;
+    // Returns nullptr if there is no such structure
+    AstStruct *getStruct(Symbol name) {
+        auto entry = structMap.find(name);
+        if (entry == structMap.end()) return nullptr;
+        return entry->second;
+    }
+    
+    bool hasStruct(Symbol name) {
+        return structMap.count(name) > 0;
     }
     
     void addGlobalStatement(AstGlobalStatement *stmt) {
@@ -48,12 +68,18 @@ public:
     
     void addStruct(AstStruct *s) {
         structs.push_back(s);
+        structMap[s->getName()] = s;
     }
     
     void print();
     void dot();
+    void stats();
+    size_t countNodes();
 private:
     std::string file = "";
     std::vector<AstGlobalStatement *> global_statements;
     std::vector<AstStruct *> structs;
+    std::unordered_map<Symbol, AstStruct *> structMap;
+    std::shared_ptr<AstArena> arena;
+    std::vector<std::shared_ptr<AstArena>> imported;
 };
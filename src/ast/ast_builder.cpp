@@ -1,52 +1,184 @@
 #include <string>
+#include <mutex>
+#include <cstdint>
+#include <unordered_map>
 
 #include <ast/ast_builder.hpp>
 #include <ast/ast.hpp>
 
 namespace AstBuilder {
 
+//
+// The canonical types
+// The primitives are built once, up front, and shared by every tree, so they
+// are the same exactly when the pointers are.
+//
+// Pointer and structure types are looked up by their base type or name in the
+// table of the current arena, and built there, so they are freed with the tree
+// (or header) that uses them, and a long-running process doesn't collect every
+// name it has ever seen. That makes them canonical only within one arena: a
+// header's types live in the header's arena, so a tree that imports it can hold
+// two different i32[] or Point objects. Those have to be compared by kind and
+// base type or name, not by pointer. A type built with no arena current goes in
+// an arena of its own, under a lock.
+//
+namespace {
+
+struct TypeTable {
+    TypeTable() {
+        AstArena::Scope noArena(nullptr);
+        
+        voidType = new AstDataType(V_AstType::Void);
+        boolType = new AstDataType(V_AstType::Bool);
+        charType = new AstDataType(V_AstType::Char);
+        stringType = new AstDataType(V_AstType::String);
+        
+        for (int isUnsigned = 0; isUnsigned<2; isUnsigned++) {
+            int8Type[isUnsigned] = new AstDataType(V_AstType::Int8, isUnsigned);
+            int16Type[isUnsigned] = new AstDataType(V_AstType::Int16, isUnsigned);
+            int32Type[isUnsigned] = new AstDataType(V_AstType::Int32, isUnsigned);
+            int64Type[isUnsigned] = new AstDataType(V_AstType::Int64, isUnsigned);
+        }
+        
+        arena = new AstArena;
+    }
+    
+    AstDataType *voidType;
+    AstDataType *boolType;
+    AstDataType *charType;
+    AstDataType *stringType;
+    AstDataType *int8Type[2];
+    AstDataType *int16Type[2];
+    AstDataType *int32Type[2];
+    AstDataType *int64Type[2];
+    
+    // The types built with no current arena
+    std::mutex lock;
+    AstArena *arena;
+};
+
+TypeTable &getTable() {
+    static TypeTable *table = new TypeTable;
+    return *table;
+}
+
+// Returns the type for key in the current arena, building it if need be
+template<class T, class Key>
+T *getCanonical(std::unordered_map<Key, T *> &types, Key key) {
+    T *&type = types[key];
+    if (type == nullptr) type = new T(key);
+    return type;
+}
+
+}
+
+// Each unit is parsed on a single thread. The primitives are shared, so the
+// distinct count has to remember which of them this thread handed out.
+static thread_local size_t typeCount = 0;
+static thread_local uint32_t primitivesUsed = 0;
+
+enum Primitive {
+    VoidBit = 1 << 0,
+    BoolBit = 1 << 1,
+    CharBit = 1 << 2,
+    StringBit = 1 << 3,
+    Int8Bit = 1 << 4,       // Each integer takes two bits; the second is unsigned
+    Int16Bit = 1 << 6,
+    Int32Bit = 1 << 8,
+    Int64Bit = 1 << 10,
+};
+
+static void usePrimitive(uint32_t bit) {
+    ++typeCount;
+    primitivesUsed |= bit;
+}
+
+size_t getTypeCount() {
+    return typeCount;
+}
+
+void resetTypeCount() {
+    typeCount = 0;
+    primitivesUsed = 0;
+}
+
+size_t getDistinctTypeCount(AstArena *arena) {
+    return __builtin_popcount(primitivesUsed) + arena->pointerTypes.size() + arena->structTypes.size();
+}
+
+void resetTypes() {
+    TypeTable &table = getTable();
+    std::lock_guard<std::mutex> guard(table.lock);
+    
+    delete table.arena;
+    table.arena = new AstArena;
+}
+
 //
 // The builders for data types
 //
 AstDataType *buildVoidType() {
-    return new AstDataType(V_AstType::Void);
+    usePrimitive(VoidBit);
+    return getTable().voidType;
 }
 
 AstDataType *buildBoolType() {
-    return new AstDataType(V_AstType::Bool);
+    usePrimitive(BoolBit);
+    return getTable().boolType;
 }
 
 AstDataType *buildCharType() {
-    return new AstDataType(V_AstType::Char);
+    usePrimitive(CharBit);
+    return getTable().charType;
 }
 
 AstDataType *buildInt8Type(bool isUnsigned) {
-    return new AstDataType(V_AstType::Int8, isUnsigned);
+    usePrimitive(Int8Bit << isUnsigned);
+    return getTable().int8Type[isUnsigned];
 }
 
 AstDataType *buildInt16Type(bool isUnsigned) {
-    return new AstDataType(V_AstType::Int16, isUnsigned);
+    usePrimitive(Int16Bit << isUnsigned);
+    return getTable().int16Type[isUnsigned];
 }
 
 AstDataType *buildInt32Type(bool isUnsigned) {
-    return new AstDataType(V_AstType::Int32, isUnsigned);
+    usePrimitive(Int32Bit << isUnsigned);
+    return getTable().int32Type[isUnsigned];
 }
 
 AstDataType *buildInt64Type(bool isUnsigned) {
-    return new AstDataType(V_AstType::Int64, isUnsigned);
+    usePrimitive(Int64Bit << isUnsigned);
+    return getTable().int64Type[isUnsigned];
 }
 
 AstDataType *buildStringType() {
-    return new AstDataType(V_AstType::String);
+    usePrimitive(StringBit);
+    return getTable().stringType;
 }
 
 AstPointerType *buildPointerType(AstDataType *base) {
-    return new AstPointerType(base);
+    ++typeCount;
+    
+    AstArena *arena = AstArena::getCurrent();
+    if (arena) return getCanonical(arena->pointerTypes, base);
+    
+    TypeTable &table = getTable();
+    std::lock_guard<std::mutex> guard(table.lock);
+    AstArena::Scope scope(table.arena);
+    return getCanonical(table.arena->pointerTypes, base);
 }
 
-AstStructType *buildStructType(std::string name) {
-    return new AstStructType(name);
+AstStructType *buildStructType(Symbol name) {
+    ++typeCount;
+    
+    AstArena *arena = AstArena::getCurrent();
+    if (arena) return getCanonical(arena->structTypes, name);
+    
+    TypeTable &table = getTable();
+    std::lock_guard<std::mutex> guard(table.lock);
+    AstArena::Scope scope(table.arena);
+    return getCanonical(table.arena->structTypes, name);
 }
 
 } // End AstBuilder
-
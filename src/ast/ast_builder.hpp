@@ -8,6 +8,9 @@ namespace AstBuilder {
 
 //
 // The builders for data types
+// These return the canonical instance of each type. Primitives can be compared
+// by pointer; pointer and structure types only within one tree or header (see
+// ast_builder.cpp). They are shared, and must never be changed.
 //
 AstDataType *buildVoidType();
 AstDataType *buildBoolType();
@@ -18,7 +21,18 @@ AstDataType *buildInt32Type(bool isUnsigned = false);
 AstDataType *buildInt64Type(bool isUnsigned = false);
 AstDataType *buildStringType();
 AstPointerType *buildPointerType(AstDataType *base);
-AstStructType *buildStructType(std::string name);
+AstStructType *buildStructType(Symbol name);
+
+// The number of data types asked for on this thread, and how many distinct type
+// objects those were: the primitives it asked for, and the pointer and structure
+// types built in the arena (for --stats)
+size_t getTypeCount();
+void resetTypeCount();
+size_t getDistinctTypeCount(AstArena *arena);
+
+// Frees the types that were built with no arena current. Nothing may still be
+// using them.
+void resetTypes();
 
 }
 
@@ -4,467 +4,170 @@
 #include <iostream>
 
 #include <ast/ast.hpp>
+#include <ast/Visitor.hpp>
 
-int idx = 0;
+//
+// Builds the graph for --dot
+// Each node the graph shows is named after its kind and a running count, and
+// stays on the parent stack while the walk goes through its children. Data
+// types and the literals without a label aren't shown, so their visit is false.
+//
+class AstDotWriter : public AstVisitor {
+public:
+    std::string output;
+protected:
+    bool visit(AstNode *node) override;
+    void leave(AstNode *node) override;
+private:
+    std::string addNode(const char *prefix, const std::string &label, const char *shape = nullptr);
+    bool enter(const char *prefix, const std::string &label, const char *shape = nullptr);
+    
+    std::vector<std::string> parents = { "tree" };
+    int idx = 0;
+};
 
 void AstTree::dot() {
+    AstDotWriter writer;
+    writer.walk(this);
+    
     std::string output = "digraph AST {\n";
     output += "tree[shape=box, label=\"" + getFile() + "\"]\n";
-    
-    for (auto s : getStructs()) {
-        output += s->dot("tree");
-    }
-    
-    for (auto global : getGlobalStatements()) {
-        output += global->dot("tree");
-    }
-    
+    output += writer.output;
     output += "}\n";
     
     // Write the file
     std::cout << output << std::endl;
     
-    std::ofstream writer("ast.dot");
-    writer << output << std::endl;
-    writer.close();
+    std::ofstream file("ast.dot");
+    file << output << std::endl;
+    file.close();
     
     system("dot -Tpng ast.dot > ast.png");
 }
 
-//
-// Structures
-//
-std::string AstStruct::dot(std::string parent) {
-    std::string name = "struct" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[shape=rect, label=\"struct " + getName() + "\"];\n";
-    output += parent + " -> " + name + ";\n";
-    
-    for (auto item : items) {
-        std::string item_name = "item" + std::to_string(idx);
-        ++idx;
+// Adds a node under the current parent, and returns its name
+std::string AstDotWriter::addNode(const char *prefix, const std::string &label, const char *shape) {
+    std::string name = prefix + std::to_string(idx);
+    ++idx;
+    
+    output.append(name).append("[");
+    if (shape) output.append("shape=").append(shape).append(", ");
+    output.append("label=\"").append(label).append("\"];\n");
+    output.append(parents.back()).append(" -> ").append(name).append(";\n");
+    return name;
+}
+
+// Adds a node and makes it the parent of whatever the walk reaches under it
+bool AstDotWriter::enter(const char *prefix, const std::string &label, const char *shape) {
+    parents.push_back(addNode(prefix, label, shape));
+    return true;
+}
+
+bool AstDotWriter::visit(AstNode *node) {
+    switch (node->getType()) {
+        //
+        // Structures
+        // The default expression of an item goes under the item
+        //
+        case V_AstType::StructDef: {
+            AstStruct *str = static_cast<AstStruct *>(node);
+            parents.push_back(addNode("struct", "struct " + str->getName().str(), "rect"));
+            
+            for (auto item : str->getItems()) {
+                parents.push_back(addNode("item", item.name.str()));
+                walk(str->getDefaultExpression(item.name));
+                parents.pop_back();
+            }
+            
+            parents.pop_back();
+        } return false;
         
-        output += item_name + "[label=\"" + item.name + "\"];\n";
-        output += name + " -> " + item_name + ";\n";
+        //
+        // Global statements (functions)
+        //
+        case V_AstType::ExternFunc: {
+            output += parents.back() + " -> " + static_cast<AstExternFunction *>(node)->getName().str() + "[shape=rect];\n";
+        } return false;
         
-        output += defaultExpressions[item.name]->dot(item_name);
-    }
-    
-    return output;
-}
-
-//
-// Global statements (functions)
-//
-std::string AstExternFunction::dot(std::string parent) {
-    return parent + " -> " + getName() + "[shape=rect];\n";
-}
-
-std::string AstFunction::dot(std::string parent) {
-    std::string output = getName() + "[shape=box];\n";
-    output += parent + " -> " + getName() + ";\n";
-    output += getBlock()->dot(getName());
-    
-    return output;
-}
-
-//
-// Blocks
-//
-std::string AstBlock::dot(std::string parent) {
-    std::string name = "block" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[shape=box, label=\"Block\"];\n";
-    output += parent + " -> " + name + ";\n";
-
-    for (auto stmt : block) {
-        output += stmt->dot(name);
+        case V_AstType::Func: {
+            std::string name = static_cast<AstFunction *>(node)->getName().str();
+            output += name + "[shape=box];\n";
+            output += parents.back() + " -> " + name + ";\n";
+            parents.push_back(name);
+        } return true;
+        
+        case V_AstType::Block: return enter("block", "Block", "box");
+        
+        //
+        // Statements
+        // Declarations are shown without their children
+        //
+        case V_AstType::ExprStmt: return enter("expr", "expression");
+        case V_AstType::FuncCallStmt: return enter("fc", static_cast<AstFuncCallStmt *>(node)->getName().str());
+        case V_AstType::Return: return enter("return", "return");
+        
+        case V_AstType::VarDec: {
+            addNode("var", "var " + static_cast<AstVarDec *>(node)->getName().str());
+        } return false;
+        
+        case V_AstType::StructDec: {
+            AstStructDec *sd = static_cast<AstStructDec *>(node);
+            addNode("struct", "struct " + sd->getVarName().str() + " : " + sd->getStructName().str());
+        } return false;
+        
+        case V_AstType::If: return enter("cond", "if");
+        case V_AstType::While: return enter("while", "while");
+        case V_AstType::Break: return enter("break", "break");
+        case V_AstType::Continue: return enter("continue", "continue");
+        
+        //
+        // Expressions
+        //
+        case V_AstType::ExprList: return enter("list", "list");
+        case V_AstType::Neg: return enter("neg", "-");
+        case V_AstType::Assign: return enter("assign", ":=");
+        case V_AstType::Add: return enter("add", "+");
+        case V_AstType::Sub: return enter("sub", "-");
+        case V_AstType::Mul: return enter("mul", "*");
+        case V_AstType::Div: return enter("div", "/");
+        case V_AstType::Mod: return enter("mod", "%");
+        case V_AstType::And: return enter("and", "&");
+        case V_AstType::Or: return enter("or", "|");
+        case V_AstType::Xor: return enter("xor", "^");
+        case V_AstType::EQ: return enter("eq", "=");
+        case V_AstType::NEQ: return enter("neq", "!=");
+        case V_AstType::GT: return enter("gt", ">");
+        case V_AstType::LT: return enter("lt", "<");
+        case V_AstType::GTE: return enter("gte", ">=");
+        case V_AstType::LTE: return enter("lte", "<=");
+        case V_AstType::LogicalAnd: return enter("and", "and");
+        case V_AstType::LogicalOr: return enter("or", "or");
+        
+        case V_AstType::CharL: {
+            return enter("char", std::string("\'") + static_cast<AstChar *>(node)->getValue() + "\'");
+        }
+        
+        case V_AstType::StringL: {
+            return enter("string", "\\\"" + static_cast<AstString *>(node)->getValue().str() + "\\\"");
+        }
+        
+        case V_AstType::I32L: return enter("int", std::to_string(static_cast<AstI32 *>(node)->getValue()));
+        case V_AstType::ID: return enter("id", static_cast<AstID *>(node)->getValue().str());
+        case V_AstType::ArrayAccess: return enter("array_acc", static_cast<AstArrayAccess *>(node)->getValue().str());
+        
+        case V_AstType::StructAccess: {
+            AstStructAccess *sa = static_cast<AstStructAccess *>(node);
+            return enter("struct_acc", sa->getName().str() + "." + sa->getMember().str());
+        }
+        
+        case V_AstType::FuncCallExpr: return enter("func_call_expr", static_cast<AstFuncCallExpr *>(node)->getName().str());
+        
+        default: {}
     }
     
-    return output;
-}
-
-//
-// Statements
-//
-std::string AstExprStatement::dot(std::string parent) {
-    std::string name = "expr" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"expression\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getExpression()->dot(name);
-    
-    return output;
-}
-
-std::string AstFuncCallStmt::dot(std::string parent) {
-    std::string name = "fc" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"" + getName() + "\"];\n";
-    output += parent + " -> " + name + ";\n";
-    
-    output += getExpression()->dot(name);
-    
-    return output;
-}
-
-std::string AstReturnStmt::dot(std::string parent) {
-    std::string name = "return" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"return\"];\n";
-    output += parent + " -> " + name + ";\n";
-    
-    if (hasExpression()) output += getExpression()->dot(name);
-    
-    return output;
-}
-
-std::string AstVarDec::dot(std::string parent) {
-    std::string name = "var" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"var " + this->name + "\"];\n";
-    output += parent + " -> " + name + ";\n";
-    
-    return output;
-}
-
-std::string AstStructDec::dot(std::string parent) {
-    std::string name = "struct" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"struct " + this->varName + " : " + this->structName + "\"];\n";
-    output += parent + " -> " + name + ";\n";
-    
-    return output;
-}
-
-std::string AstIfStmt::dot(std::string parent) {
-    std::string name = "cond" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"if\"];\n";
-    output += parent + " -> " + name + ";\n";
-    
-    output += getExpression()->dot(name);
-    output += trueBlock->dot(name);
-    output += falseBlock->dot(name);
-    
-    return output;
+    return false;
 }
 
-std::string AstWhileStmt::dot(std::string parent) {
-    std::string name = "while" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"while\"];\n";
-    output += parent + " -> " + name + ";\n";
-    
-    output += getExpression()->dot(name);
-    output += block->dot(name);
-    
-    return output;
+void AstDotWriter::leave(AstNode *) {
+    parents.pop_back();
 }
-
-std::string AstBreak::dot(std::string parent) {
-    std::string name = "break" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"break\"];\n";
-    output += parent + " -> " + name + ";\n";
-    
-    return output;
-}
-
-std::string AstContinue::dot(std::string parent) {
-    std::string name = "continue" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"continue\"];\n";
-    output += parent + " -> " + name + ";\n";
-    
-    return output;
-}
-
-//
-// Expressions
-//
-std::string AstExprList::dot(std::string parent) {
-    std::string name = "list" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"list\"];\n";
-    output += parent + " -> " + name + ";\n";
-    
-    for (auto expr : list) output += expr->dot(name);
-    
-    return output;
-}
-
-std::string AstNegOp::dot(std::string parent) {
-    std::string name = "neg" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"-\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getVal()->dot(name);
-    return output;
-}
-
-std::string AstAssignOp::dot(std::string parent) {
-    std::string name = "assign" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\":=\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getLVal()->dot(name);
-    output += getRVal()->dot(name);
-    return output;
-}
-
-std::string AstAddOp::dot(std::string parent) {
-    std::string name = "add" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"+\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getLVal()->dot(name);
-    output += getRVal()->dot(name);
-    return output;
-}
-
-std::string AstSubOp::dot(std::string parent) {
-    std::string name = "sub" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"-\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getLVal()->dot(name);
-    output += getRVal()->dot(name);
-    return output;
-}
-
-std::string AstMulOp::dot(std::string parent) {
-    std::string name = "mul" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"*\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getLVal()->dot(name);
-    output += getRVal()->dot(name);
-    return output;
-}
-
-std::string AstDivOp::dot(std::string parent) {
-    std::string name = "div" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"/\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getLVal()->dot(name);
-    output += getRVal()->dot(name);
-    return output;
-}
-
-std::string AstModOp::dot(std::string parent) {
-    std::string name = "mod" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"%\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getLVal()->dot(name);
-    output += getRVal()->dot(name);
-    return output;
-}
-
-std::string AstAndOp::dot(std::string parent) {
-    std::string name = "and" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"&\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getLVal()->dot(name);
-    output += getRVal()->dot(name);
-    return output;
-}
-
-std::string AstOrOp::dot(std::string parent) {
-    std::string name = "or" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"|\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getLVal()->dot(name);
-    output += getRVal()->dot(name);
-    return output;
-}
-
-std::string AstXorOp::dot(std::string parent) {
-    std::string name = "xor" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"^\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getLVal()->dot(name);
-    output += getRVal()->dot(name);
-    return output;
-}
-
-std::string AstEQOp::dot(std::string parent) {
-    std::string name = "eq" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"=\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getLVal()->dot(name);
-    output += getRVal()->dot(name);
-    return output;
-}
-
-std::string AstNEQOp::dot(std::string parent) {
-    std::string name = "neq" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"!=\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getLVal()->dot(name);
-    output += getRVal()->dot(name);
-    return output;
-}
-
-std::string AstGTOp::dot(std::string parent) {
-    std::string name = "gt" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\">\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getLVal()->dot(name);
-    output += getRVal()->dot(name);
-    return output;
-}
-
-std::string AstLTOp::dot(std::string parent) {
-    std::string name = "lt" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"<\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getLVal()->dot(name);
-    output += getRVal()->dot(name);
-    return output;
-}
-
-std::string AstGTEOp::dot(std::string parent) {
-    std::string name = "gte" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\">=\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getLVal()->dot(name);
-    output += getRVal()->dot(name);
-    return output;
-}
-
-std::string AstLTEOp::dot(std::string parent) {
-    std::string name = "lte" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"<=\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getLVal()->dot(name);
-    output += getRVal()->dot(name);
-    return output;
-}
-
-std::string AstLogicalAndOp::dot(std::string parent) {
-    std::string name = "and" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"and\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getLVal()->dot(name);
-    output += getRVal()->dot(name);
-    return output;
-}
-
-std::string AstLogicalOrOp::dot(std::string parent) {
-    std::string name = "or" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"or\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getLVal()->dot(name);
-    output += getRVal()->dot(name);
-    return output;
-}
-
-std::string AstChar::dot(std::string parent) {
-    std::string name = "char" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"\'" + getValue() + "\'\"];\n";
-    output += parent + " -> " + name + ";\n";
-    return output;
-}
-
-std::string AstString::dot(std::string parent) {
-    std::string name = "string" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"\\\"" + getValue() + "\\\"\"];\n";
-    output += parent + " -> " + name + ";\n";
-    return output;
-}
-
-std::string AstI32::dot(std::string parent) {
-    std::string name = "int" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"" + std::to_string(getValue()) + "\"];\n";
-    output += parent + " -> " + name + ";\n";
-    return output;
-}
-
-std::string AstID::dot(std::string parent) {
-    std::string name = "id" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"" + getValue() + "\"];\n";
-    output += parent + " -> " + name + ";\n";
-    return output;
-}
-
-std::string AstArrayAccess::dot(std::string parent) {
-    std::string name = "array_acc" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"" + getValue() + "\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getIndex()->dot(name);
-    return output;
-}
-
-std::string AstStructAccess::dot(std::string parent) {
-    std::string name = "struct_acc" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"" + getName() + "." + getMember() + "\"];\n";
-    output += parent + " -> " + name + ";\n";
-    return output;
-}
-
-std::string AstFuncCallExpr::dot(std::string parent) {
-    std::string name = "func_call_expr" + std::to_string(idx);
-    ++idx;
-    
-    std::string output = name + "[label=\"" + getName() + "\"];\n";
-    output += parent + " -> " + name + ";\n";
-    output += getArgExpression()->dot(name);
-    return output;
-}
-
@@ -5,26 +5,183 @@
 //
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/Program.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/MC/TargetRegistry.h"
+#include "llvm/MC/MCSubtargetInfo.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
 #include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/IR/PassInstrumentation.h"
+
+#ifdef TL_HAS_LLD
+#include "lld/Common/Driver.h"
+#endif
+
+#include <mutex>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
 
 using namespace llvm;
 using namespace llvm::sys;
 
 #include "Compiler.hpp"
 
-void Compiler::writeAssembly() {
+// Per-pass times for -ftime-report
+// Every unit adds into the same process-wide totals, so with -j there is still
+// one report for the whole run, printed by the driver once all units are done.
+// (LLVM's TimePassesHandler prints one report per pipeline, from whichever
+// thread happens to finish it.)
+struct PassTotal {
+    double wall = 0;
+    int count = 0;
+};
+
+static std::mutex passTimesLock;
+static std::map<std::string, PassTotal> passTimes;
+
+// Times the passes of one pipeline. Nested passes are timed exclusively: the
+// enclosing pass is paused while they run. Pass managers and adaptors only
+// run other passes, so they are left out like LLVM does.
+class PassTimer {
+public:
+    void registerCallbacks(PassInstrumentationCallbacks &callbacks) {
+        callbacks.registerBeforeNonSkippedPassCallback([this](StringRef pass, Any) { start(pass); });
+        callbacks.registerAfterPassCallback([this](StringRef pass, Any, const PreservedAnalyses &) { stop(pass); });
+        callbacks.registerAfterPassInvalidatedCallback([this](StringRef pass, const PreservedAnalyses &) { stop(pass); });
+        callbacks.registerBeforeAnalysisCallback([this](StringRef pass, Any) { start(pass); });
+        callbacks.registerAfterAnalysisCallback([this](StringRef pass, Any) { stop(pass); });
+    }
+    
+    // Adds this pipeline's times to the totals
+    ~PassTimer() {
+        std::lock_guard<std::mutex> lock(passTimesLock);
+        for (auto &entry : times) {
+            PassTotal &total = passTimes[entry.first];
+            total.wall += entry.second.wall;
+            total.count += entry.second.count;
+        }
+    }
+private:
+    typedef std::chrono::steady_clock Clock;
+    
+    bool isSkipped(StringRef pass) {
+        return isSpecialPass(pass, {"PassManager", "PassAdaptor", "AnalysisManagerProxy",
+            "ModuleInlinerWrapperPass", "DevirtSCCRepeatedPass"});
+    }
+    
+    void start(StringRef pass) {
+        if (isSkipped(pass)) return;
+        Clock::time_point now = Clock::now();
+        if (!running.empty()) pause(now);
+        running.push_back({pass.str(), now});
+        ++times[pass.str()].count;
+    }
+    
+    void stop(StringRef pass) {
+        if (isSkipped(pass) || running.empty()) return;
+        Clock::time_point now = Clock::now();
+        pause(now);
+        running.pop_back();
+        if (!running.empty()) running.back().second = now;
+    }
+    
+    // Charges the innermost running pass for the time since it last started
+    void pause(Clock::time_point now) {
+        std::chrono::duration<double> elapsed = now - running.back().second;
+        times[running.back().first].wall += elapsed.count();
+    }
+    
+    std::vector<std::pair<std::string, Clock::time_point>> running;
+    std::map<std::string, PassTotal> times;
+};
+
+// Prints the per-pass totals to stderr, slowest first, and clears them
+void Compiler::printPassTimes() {
+    std::vector<std::pair<std::string, PassTotal>> sorted;
+    {
+        std::lock_guard<std::mutex> lock(passTimesLock);
+        sorted.assign(passTimes.begin(), passTimes.end());
+        passTimes.clear();
+    }
+    if (sorted.empty()) return;
+    
+    std::stable_sort(sorted.begin(), sorted.end(), [](auto &a, auto &b) {
+        return a.second.wall > b.second.wall;
+    });
+    
+    double totalWall = 0;
+    for (auto &entry : sorted) totalWall += entry.second.wall;
+    
+    std::cerr << "===-------------------------------------------------------------------------===" << std::endl;
+    std::cerr << "                       tlc optimizer pass timing report" << std::endl;
+    std::cerr << "===-------------------------------------------------------------------------===" << std::endl;
+    std::cerr << std::right << std::setw(14) << "Wall (s)" << std::setw(10) << "Count" << "  Pass" << std::endl;
+    
+    std::cerr << std::fixed << std::setprecision(4);
+    for (auto &entry : sorted) {
+        std::cerr << std::setw(14) << entry.second.wall << std::setw(10) << entry.second.count
+            << "  " << entry.first << std::endl;
+    }
+    std::cerr << std::setw(14) << totalWall << std::setw(10) << "" << "  Total" << std::endl;
+    std::cerr << std::defaultfloat;
+}
+
+void Compiler::resetPassTimes() {
+    std::lock_guard<std::mutex> lock(passTimesLock);
+    passTimes.clear();
+}
+
+// Replaces "native" with the host CPU name and features. Anything given
+// with -mattr is added after the host features so it can override them.
+// The host features are sorted so the same host always gives the same string.
+void Compiler::resolveTargetCPU(CFlags &flags) {
+    if (flags.cpu != "native") return;
+    
+    flags.cpu = sys::getHostCPUName().str();
+    
+    std::vector<std::string> featureList;
+    StringMap<bool> hostFeatures;
+    if (sys::getHostCPUFeatures(hostFeatures)) {
+        for (auto &feature : hostFeatures) {
+            featureList.push_back((feature.second ? "+" : "-") + feature.first().str());
+        }
+    }
+    std::sort(featureList.begin(), featureList.end());
+    
+    std::string features = "";
+    for (auto &feature : featureList) {
+        if (features != "") features += ",";
+        features += feature;
+    }
+    
+    if (flags.features != "") {
+        if (features != "") features += ",";
+        features += flags.features;
+    }
+    flags.features = features;
+}
+
+// Sets up the target and the target machine for the module
+TargetMachine *Compiler::buildTargetMachine() {
+    if (targetMachine) return targetMachine.get();
+    
     std::string triple = "";
 
-    LLVMInitializeX86TargetInfo();
-    LLVMInitializeX86Target();
-    LLVMInitializeX86TargetMC();
-    LLVMInitializeX86AsmParser();
-    LLVMInitializeX86AsmPrinter();
+    // The target registry is global, so only set it up once per process
+    static std::once_flag targetInitialized;
+    std::call_once(targetInitialized, []() {
+        LLVMInitializeX86TargetInfo();
+        LLVMInitializeX86Target();
+        LLVMInitializeX86TargetMC();
+        LLVMInitializeX86AsmParser();
+        LLVMInitializeX86AsmPrinter();
+    });
     
     triple = sys::getDefaultTargetTriple();
     mod->setTargetTriple(triple);
@@ -35,26 +192,125 @@ void Compiler::writeAssembly() {
     // Check for any errors with the target triple
     if (!target) {
         errs() << error;
-        return;
+        return nullptr;
     }
     
     // CPU and features
-    auto CPU = "generic";
-    auto features = "";
+    std::string CPU = cflags.cpu;
+    std::string features = cflags.features;
+    
+    std::unique_ptr<MCSubtargetInfo> subtargetInfo(target->createMCSubtargetInfo(triple, "", ""));
+    if (!subtargetInfo->isCPUStringValid(CPU)) {
+        errs() << "Error: Unknown CPU: " << CPU << "\n";
+        return nullptr;
+    }
+    
+    // Code generation level; -Os generates like -O2
+    CodeGenOpt::Level codeGenLevel = CodeGenOpt::Default;
+    switch (cflags.optLevel) {
+        case 0: codeGenLevel = CodeGenOpt::None; break;
+        case 1: codeGenLevel = CodeGenOpt::Less; break;
+        case 3: codeGenLevel = CodeGenOpt::Aggressive; break;
+        default: {}
+    }
+    if (cflags.optSize) codeGenLevel = CodeGenOpt::Default;
     
     TargetOptions options;
     auto RM = Optional<Reloc::Model>();
-    auto machine = target->createTargetMachine(triple, CPU, features, options, RM);
-    mod->setDataLayout(machine->createDataLayout());
+    targetMachine.reset(target->createTargetMachine(triple, CPU, features, options, RM, None, codeGenLevel));
+    mod->setDataLayout(targetMachine->createDataLayout());
     
-    // Write it out
-    std::string outputPath = "/tmp/" + cflags.name + ".asm";
+    return targetMachine.get();
+}
+
+// Runs the IR optimization pipeline for the selected -O level
+bool Compiler::optimize() {
+    TargetMachine *machine = buildTargetMachine();
+    if (!machine) return false;
+    
+    // Invalid IR is a bug in the compiler, not the program, so nothing gets
+    // emitted from it (the pipelines also assume valid IR)
+    if (verifyModule(*mod, &errs())) {
+        errs() << "Error: Internal compiler error: invalid module generated for " << cflags.name << ".\n";
+        return false;
+    }
+    
+    if (cflags.optLevel == 0 && !cflags.optSize) return true;
+    
+    OptimizationLevel level = OptimizationLevel::O2;
+    switch (cflags.optLevel) {
+        case 1: level = OptimizationLevel::O1; break;
+        case 3: level = OptimizationLevel::O3; break;
+        default: {}
+    }
+    if (cflags.optSize) level = OptimizationLevel::Os;
+    
+    LoopAnalysisManager LAM;
+    FunctionAnalysisManager FAM;
+    CGSCCAnalysisManager CGAM;
+    ModuleAnalysisManager MAM;
+    
+    // Per-pass timing; the totals are printed after all units are done
+    PassInstrumentationCallbacks instrumentation;
+    PassTimer passTimer;
+    if (cflags.timePasses) passTimer.registerCallbacks(instrumentation);
+    
+    PassBuilder passBuilder(machine, PipelineTuningOptions(), None, &instrumentation);
+    passBuilder.registerModuleAnalyses(MAM);
+    passBuilder.registerCGSCCAnalyses(CGAM);
+    passBuilder.registerFunctionAnalyses(FAM);
+    passBuilder.registerLoopAnalyses(LAM);
+    passBuilder.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+    
+    ModulePassManager pipeline = passBuilder.buildPerModuleDefaultPipeline(level);
+    pipeline.run(*mod, MAM);
+    return true;
+}
+
+// Emits the object code straight into memory
+bool Compiler::writeObject() {
+    TargetMachine *machine = buildTargetMachine();
+    if (!machine) return false;
+    
+    objectBuffer.clear();
+    raw_svector_ostream writer(objectBuffer);
+    
+    legacy::PassManager pass;
+    auto outputType = CGFT_ObjectFile;
+    
+    if (machine->addPassesToEmitFile(pass, writer, nullptr, outputType)) {
+        errs() << "Unable to emit object code.\n";
+        return false;
+    }
+    
+    pass.run(*mod);
+    return true;
+}
+
+// Writes the object buffer out to disk
+bool Compiler::writeObjectFile(std::string path) {
+    std::error_code errorCode;
+    raw_fd_ostream writer(path, errorCode, sys::fs::OF_None);
+    
+    if (errorCode) {
+        errs() << "Unable to open file: " << errorCode.message() << "\n";
+        return false;
+    }
+    
+    writer.write(objectBuffer.data(), objectBuffer.size());
+    return true;
+}
+
+void Compiler::writeAssembly(std::string outputPath) {
+    TargetMachine *machine = buildTargetMachine();
+    if (!machine) return;
     
+    // Write it out
     std::error_code errorCode;
     raw_fd_ostream writer(outputPath, errorCode, sys::fs::OF_None);
     
     if (errorCode) {
-        errs() << "Unable to open file: " << errorCode.message();
+        errs() << "Unable to open file: " << errorCode.message() << "\n";
         return;
     }
     
@@ -62,7 +318,7 @@ void Compiler::writeAssembly() {
     auto outputType = CGFT_AssemblyFile;
     
     if (machine->addPassesToEmitFile(pass, writer, nullptr, outputType)) {
-        errs() << "Unable to write to file.";
+        errs() << "Unable to write to file.\n";
         return;
     }
     
@@ -71,20 +327,51 @@ void Compiler::writeAssembly() {
 }
 
 // Assemble the file
-// TODO: This needs to be done properly. System() != proper. I was lazy
-void Compiler::assemble() {
-    std::string cmd = "as /tmp/" + cflags.name + ".asm -o /tmp/" + cflags.name + ".o";
+// This is only used with --external-tools; the default path never leaves the object in text form
+void Compiler::assemble(std::string asmPath, std::string objPath) {
+    std::string cmd = "as " + asmPath + " -o " + objPath;
     system(cmd.c_str());
 }
 
 // Link
-// TODO: Same as above...
-void Compiler::link() {
-    std::string cmd = "ld ";
-    cmd += "/usr/local/lib/tinylang/ti_start.o ";
-    cmd += "/tmp/" + cflags.name + ".o -o " + cflags.name;
-    cmd += " -dynamic-linker /lib64/ld-linux-x86-64.so.2 ";
-    cmd += "-ltinylang -lc";
-    system(cmd.c_str());
+// Links all the given objects into the flags.name executable. By default, this is done
+// with LLD if we were built with it, or with a direct ld call otherwise. The old shell
+// path is kept for --external-tools
+bool Compiler::link(std::vector<std::string> objects, CFlags flags) {
+    if (flags.externalTools) {
+        std::string cmd = "ld ";
+        cmd += "/usr/local/lib/tinylang/ti_start.o ";
+        for (auto &obj : objects) cmd += obj + " ";
+        cmd += "-o " + flags.name;
+        cmd += " -dynamic-linker /lib64/ld-linux-x86-64.so.2 ";
+        cmd += "-ltinylang -lc";
+        return system(cmd.c_str()) == 0;
+    }
+    
+    std::vector<std::string> args = { "ld", "/usr/local/lib/tinylang/ti_start.o" };
+    for (auto &obj : objects) args.push_back(obj);
+    args.insert(args.end(), {
+        "-o", flags.name,
+        "-dynamic-linker", "/lib64/ld-linux-x86-64.so.2",
+        "-ltinylang", "-lc"
+    });
+    
+#ifdef TL_HAS_LLD
+    std::vector<const char *> lldArgs;
+    for (auto &arg : args) lldArgs.push_back(arg.c_str());
+    return lld::elf::link(lldArgs, outs(), errs(), false, false);
+#else
+    auto ld = sys::findProgramByName("ld");
+    if (!ld) {
+        errs() << "Error: Unable to find the system linker.\n";
+        return false;
+    }
+    
+    std::vector<StringRef> ldArgs;
+    for (auto &arg : args) ldArgs.push_back(arg);
+    std::string error = "";
+    bool success = sys::ExecuteAndWait(*ld, ldArgs, None, {}, 0, 0, &error) == 0;
+    if (error != "") errs() << "Error: " << error << "\n";
+    return success;
+#endif
 }
-
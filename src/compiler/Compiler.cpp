@@ -4,6 +4,7 @@
 // Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
 //
 #include "llvm/IR/BasicBlock.h"
+#include "llvm/Support/Format.h"
 #include "llvm/MC/TargetRegistry.h"
 #include "llvm/Support/CommandLine.h"
 
@@ -12,62 +13,91 @@ using namespace llvm::sys;
 
 #include <iostream>
 #include <exception>
+#include <mutex>
 
 #include "Compiler.hpp"
 #include <llvm-c/Support.h>
 
 Compiler::Compiler(AstTree *tree, CFlags cflags) {
-    char const *args[] = { "", "--x86-asm-syntax=intel" };
-    LLVMParseCommandLineOptions(2, args, NULL);
+    // LLVM's options are global, so only parse them once per process
+    static std::once_flag optionsParsed;
+    std::call_once(optionsParsed, []() {
+        char const *args[] = { "", "--x86-asm-syntax=intel" };
+        LLVMParseCommandLineOptions(2, args, NULL);
+    });
     
     this->tree = tree;
     this->cflags = cflags;
+    resolveTargetCPU(this->cflags);
 
     context = std::make_unique<LLVMContext>();
+    context->enableOpaquePointers();
     mod = std::make_unique<Module>(cflags.name, *context);
     builder = std::make_unique<IRBuilder<>>(*context);
 }
 
-void Compiler::compile() {
-    // Build the structures used by the program
-    for (auto str : tree->getStructs()) {
-        std::vector<Type *> elementTypes;
-        
-        for (auto v : str->getItems()) {
-            Type *t = translateType(v.type);
-            elementTypes.push_back(t);
-        }
-        
-        StructType *s = StructType::create(*context, elementTypes);
-        s->setName(str->getName());
+// Returns false if the program has an error only found here
+bool Compiler::compile() {
+    // The few data types built here go with the tree
+    AstArena::Scope arena(tree->getArena().get());
+    
+    // The structures come first, then the functions
+    walk(tree);
+    
+    return !isError;
+}
+
+// Compiles whatever the walk reaches. Blocks are the only nodes whose children
+// are left to the walk; everything else compiles its own.
+bool Compiler::visit(AstNode *node) {
+    switch (node->getType()) {
+        case V_AstType::StructDef: compileStruct(static_cast<AstStruct *>(node)); break;
+        case V_AstType::Func: compileFunction(static_cast<AstGlobalStatement *>(node)); break;
+        case V_AstType::ExternFunc: compileExternFunction(static_cast<AstGlobalStatement *>(node)); break;
+        case V_AstType::Block: return true;
         
-        structTable[str->getName()] = s;
-        structElementTypeTable[str->getName()] = elementTypes;
+        default: compileStatement(static_cast<AstStatement *>(node));
     }
+    
+    return false;
+}
 
-    // Build all other functions
-    for (auto global : tree->getGlobalStatements()) {
-        switch (global->getType()) {
-            case V_AstType::Func: {
-                symtable.clear();
-                typeTable.clear();
-                
-                compileFunction(global);
-            } break;
-            
-            case V_AstType::ExternFunc: {
-                compileExternFunction(global);
-            } break;
-
-            default: {}
-        }
+// Builds a structure used by the program
+void Compiler::compileStruct(AstStruct *str) {
+    std::vector<Type *> elementTypes;
+    
+    for (auto v : str->getItems()) {
+        Type *t = translateType(v.type);
+        elementTypes.push_back(t);
     }
+    
+    StructType *s = StructType::create(*context, elementTypes);
+    s->setName(str->getName().str());
+    
+    structTable[str->getName()] = s;
 }
 
 void Compiler::debug() {
     mod->print(errs(), nullptr);
 }
 
+// Prints the size of each function for --stats
+void Compiler::stats(std::string phase) {
+    unsigned totalInstrs = 0, totalBlocks = 0;
+    
+    errs() << "LLVM IR after " << phase << " (" << mod->getName() << "):\n";
+    for (Function &func : *mod) {
+        if (func.isDeclaration()) continue;
+        errs() << "  " << left_justify(func.getName(), 24)
+            << format_decimal(func.getInstructionCount(), 8) << " instrs"
+            << format_decimal(func.size(), 8) << " blocks\n";
+        totalInstrs += func.getInstructionCount();
+        totalBlocks += func.size();
+    }
+    errs() << "  " << left_justify("Total", 24) << format_decimal(totalInstrs, 8) << " instrs"
+        << format_decimal(totalBlocks, 8) << " blocks\n";
+}
+
 void Compiler::emitLLVM(std::string path) {
     std::error_code errorCode;
     raw_fd_ostream writer(path, errorCode);
@@ -89,9 +119,8 @@ void Compiler::compileStatement(AstStatement *stmt) {
             AstVarDec *vd = static_cast<AstVarDec *>(stmt);
             Type *type = translateType(vd->getDataType());
             
-            AllocaInst *var = builder->CreateAlloca(type);
-            symtable[vd->getName()] = var;
-            typeTable[vd->getName()] = vd->getDataType();
+            AllocaInst *var = createEntryAlloca(type);
+            declareVar(vd->getName(), var, vd->getDataType());
         } break;
         
         // A structure declaration
@@ -161,7 +190,7 @@ Value *Compiler::compileValue(AstExpression *expr, bool isAssign) {
         
         case V_AstType::StringL: {
             AstString *str = static_cast<AstString *>(expr);
-            return builder->CreateGlobalStringPtr(str->getValue());
+            return builder->CreateGlobalStringPtr(str->getValue().str());
         } break;
         
         case V_AstType::ID: {
@@ -211,7 +240,7 @@ Value *Compiler::compileValue(AstExpression *expr, bool isAssign) {
                 args.push_back(val);
             }
             
-            Function *callee = mod->getFunction(fc->getName());
+            Function *callee = mod->getFunction(fc->getName().str());
             if (!callee) std::cerr << "Invalid function call statement." << std::endl;
             return builder->CreateCall(callee, args);
         } break;
@@ -240,7 +269,7 @@ Value *Compiler::compileValue(AstExpression *expr, bool isAssign) {
             AstExpression *rvalExpr = op->getRVal();
             
             // We only want the LVal first
-            Value *lval = compileValue(lvalExpr);
+            Value *lval = toCondition(compileValue(lvalExpr));
             
             // Create the blocks
             BasicBlock *trueBlock = BasicBlock::Create(*context, "true" + std::to_string(blockCount), currentFunc);
@@ -341,13 +370,30 @@ Value *Compiler::compileValue(AstExpression *expr, bool isAssign) {
                 }
             }
             
-            // Otherwise, build a normal comparison
+            // Otherwise, build a normal comparison. Mixed widths (i + '0') are done
+            // in the wider type.
+            if (lval->getType()->isIntegerTy() && rval->getType()->isIntegerTy()) {
+                unsigned lbits = lval->getType()->getIntegerBitWidth();
+                unsigned rbits = rval->getType()->getIntegerBitWidth();
+                if (lbits < rbits) lval = widen(lval, lvalExpr, rval->getType());
+                else if (rbits < lbits) rval = widen(rval, rvalExpr, lval->getType());
+            }
+            
+            // As in C, an unsigned operand makes the whole operation unsigned
+            bool isUnsigned = isUnsignedValue(lvalExpr) || isUnsignedValue(rvalExpr);
+            
             switch (expr->getType()) {
                 case V_AstType::Add: return builder->CreateAdd(lval, rval);
                 case V_AstType::Sub: return builder->CreateSub(lval, rval);
                 case V_AstType::Mul: return builder->CreateMul(lval, rval);
-                case V_AstType::Div: return builder->CreateSDiv(lval, rval);
-                case V_AstType::Mod: return builder->CreateSRem(lval, rval);
+                case V_AstType::Div: {
+                    if (isUnsigned) return builder->CreateUDiv(lval, rval);
+                    return builder->CreateSDiv(lval, rval);
+                }
+                case V_AstType::Mod: {
+                    if (isUnsigned) return builder->CreateURem(lval, rval);
+                    return builder->CreateSRem(lval, rval);
+                }
                 
                 case V_AstType::And: return builder->CreateAnd(lval, rval);
                 case V_AstType::Or:  return builder->CreateOr(lval, rval);
@@ -355,10 +401,22 @@ Value *Compiler::compileValue(AstExpression *expr, bool isAssign) {
                     
                 case V_AstType::EQ: return builder->CreateICmpEQ(lval, rval);
                 case V_AstType::NEQ: return builder->CreateICmpNE(lval, rval);
-                case V_AstType::GT: return builder->CreateICmpSGT(lval, rval);
-                case V_AstType::LT: return builder->CreateICmpSLT(lval, rval);
-                case V_AstType::GTE: return builder->CreateICmpSGE(lval, rval);
-                case V_AstType::LTE: return builder->CreateICmpSLE(lval, rval);
+                case V_AstType::GT: {
+                    if (isUnsigned) return builder->CreateICmpUGT(lval, rval);
+                    return builder->CreateICmpSGT(lval, rval);
+                }
+                case V_AstType::LT: {
+                    if (isUnsigned) return builder->CreateICmpULT(lval, rval);
+                    return builder->CreateICmpSLT(lval, rval);
+                }
+                case V_AstType::GTE: {
+                    if (isUnsigned) return builder->CreateICmpUGE(lval, rval);
+                    return builder->CreateICmpSGE(lval, rval);
+                }
+                case V_AstType::LTE: {
+                    if (isUnsigned) return builder->CreateICmpULE(lval, rval);
+                    return builder->CreateICmpSLE(lval, rval);
+                }
                     
                 default: {}
             }
@@ -370,8 +428,14 @@ Value *Compiler::compileValue(AstExpression *expr, bool isAssign) {
     return nullptr;
 }
 
+// The AST types are canonical, so each one is only translated once. A header's
+// pointer and struct types are separate objects from the unit's, and just get
+// their own entries.
 Type *Compiler::translateType(AstDataType *dataType) {
-    Type *type;
+    auto cached = typeCache.find(dataType);
+    if (cached != typeCache.end()) return cached->second;
+    
+    Type *type = nullptr;
     
     switch (dataType->getType()) {
         case V_AstType::Void: type = Type::getVoidTy(*context); break;
@@ -397,22 +461,84 @@ Type *Compiler::translateType(AstDataType *dataType) {
         default: {}
     }
     
+    // A structure that isn't built yet doesn't have a type to keep
+    if (type) typeCache[dataType] = type;
     return type;
 }
 
-int Compiler::getStructIndex(std::string name, std::string member) {
-    std::string name2 = structVarTable[name];
-    if (name2 != "") name = name2;
+// Whether a value is unsigned in the source, so it widens with zeros. Bools and
+// comparison results count too.
+bool Compiler::isUnsignedValue(AstExpression *expr) {
+    AstDataType *type = nullptr;
     
-    for (auto s : tree->getStructs()) {
-        if (s->getName() != name) continue;
-
-        std::vector<Var> members = s->getItems();
-        for (int i = 0; i<members.size(); i++) {
-            if (members.at(i).name == member) return i;
+    switch (expr->getType()) {
+        case V_AstType::ID: {
+            auto entry = typeTable.find(static_cast<AstID *>(expr)->getValue());
+            if (entry != typeTable.end()) type = entry->second;
+        } break;
+        
+        case V_AstType::ArrayAccess: {
+            auto entry = typeTable.find(static_cast<AstArrayAccess *>(expr)->getValue());
+            if (entry != typeTable.end() && entry->second->getType() == V_AstType::Ptr) {
+                type = static_cast<AstPointerType *>(entry->second)->getBaseType();
+            }
+        } break;
+        
+        case V_AstType::StructAccess: {
+            AstStructAccess *sa = static_cast<AstStructAccess *>(expr);
+            auto entry = structVarTable.find(sa->getName());
+            if (entry == structVarTable.end()) break;
+            
+            StructMember *member = entry->second->getMember(sa->getMember());
+            if (member) type = member->type;
+        } break;
+        
+        // Arithmetic on an unsigned operand stays unsigned
+        case V_AstType::Add:
+        case V_AstType::Sub:
+        case V_AstType::Mul:
+        case V_AstType::Div:
+        case V_AstType::Mod:
+        case V_AstType::And:
+        case V_AstType::Or:
+        case V_AstType::Xor: {
+            AstBinaryOp *op = static_cast<AstBinaryOp *>(expr);
+            return isUnsignedValue(op->getLVal()) || isUnsignedValue(op->getRVal());
         }
+        
+        case V_AstType::EQ:
+        case V_AstType::NEQ:
+        case V_AstType::GT:
+        case V_AstType::LT:
+        case V_AstType::GTE:
+        case V_AstType::LTE:
+        case V_AstType::LogicalAnd:
+        case V_AstType::LogicalOr: return true;
+        
+        default: {}
     }
+    
+    if (type == nullptr) return false;
+    return type->isUnsigned() || type->getType() == V_AstType::Bool;
+}
+
+// Extends an integer to a wider type, by the signedness of its expression
+Value *Compiler::widen(Value *value, AstExpression *expr, Type *type) {
+    if (isUnsignedValue(expr)) return builder->CreateZExt(value, type);
+    return builder->CreateSExt(value, type);
+}
+
+// Branches need an i1; anything else (a call returning bool, say) is true if it isn't zero
+Value *Compiler::toCondition(Value *value) {
+    if (value->getType()->isIntegerTy(1)) return value;
+    return builder->CreateICmpNE(value, Constant::getNullValue(value->getType()));
+}
 
-    return 0;
+// Creates a stack variable at the top of the current function. Keeping all allocas
+// in the entry block lets the optimizer promote them to registers.
+AllocaInst *Compiler::createEntryAlloca(Type *type) {
+    BasicBlock *entry = &currentFunc->getEntryBlock();
+    IRBuilder<> entryBuilder(entry, entry->begin());
+    return entryBuilder.CreateAlloca(type);
 }
 
@@ -8,33 +8,62 @@
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Target/TargetMachine.h"
 
 using namespace llvm;
 
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <stack>
 
 #include <ast/ast.hpp>
+#include <ast/Visitor.hpp>
 
 struct CFlags {
     std::string name;
+    bool externalTools = false;     // Go through as/ld with a text assembly file
+    int optLevel = 0;               // 0-3, as given by -O<n>
+    bool optSize = false;           // -Os
+    std::string cpu = "generic";    // -mcpu/-march; "native" means the host CPU
+    std::string features = "";      // -mattr, in LLVM's "+feature,-feature" form
+    bool timePasses = false;        // Report per-pass times for the optimizer (-ftime-report)
 };
 
-class Compiler {
+// The tree is compiled in one walk: the visitor reaches the structures, the
+// functions, and the statements in their blocks, and each statement compiles
+// its own expressions.
+class Compiler : public AstVisitor {
 public:
     explicit Compiler(AstTree *tree, CFlags flags);
-    void compile();
+    bool compile();
+    bool optimize();
     void debug();
+    void stats(std::string phase);
     void emitLLVM(std::string path);
-    void writeAssembly();
-    void assemble();
-    void link();
+    bool writeObject();
+    bool writeObjectFile(std::string path);
+    void writeAssembly(std::string outputPath);
+    void assemble(std::string asmPath, std::string objPath);
+    int run(std::vector<std::string> args);
+    
+    static bool link(std::vector<std::string> objects, CFlags flags);
+    static void resolveTargetCPU(CFlags &flags);
+    static void printPassTimes();
+    static void resetPassTimes();
 protected:
+    TargetMachine *buildTargetMachine();
+
+    bool visit(AstNode *node) override;
+    void compileStruct(AstStruct *str);
     void compileStatement(AstStatement *stmt);
     Value *compileValue(AstExpression *expr, bool isAssign = false);
     Type *translateType(AstDataType *dataType);
-    int getStructIndex(std::string name, std::string member);
+    bool isUnsignedValue(AstExpression *expr);
+    Value *widen(Value *value, AstExpression *expr, Type *type);
+    Value *toCondition(Value *value);
+    AllocaInst *createEntryAlloca(Type *type);
 
     // Function.cpp
     void compileFunction(AstGlobalStatement *global);
@@ -43,31 +72,50 @@ protected:
     void compileReturnStatement(AstStatement *stmt);
     
     // Flow.cpp
+    bool compileBlock(AstBlock *block);
     void compileIfStatement(AstStatement *stmt);
     void compileWhileStatement(AstStatement *stmt);
     
     // Variable.cpp
+    void declareVar(Symbol name, AllocaInst *ptr, AstDataType *type, AstStruct *str = nullptr);
+    void exitScope(size_t start);
+    void clearVars();
     void compileStructDeclaration(AstStatement *stmt);
     Value *compileStructAccess(AstExpression *expr, bool isAssign = false);
 private:
     AstTree *tree;
     CFlags cflags;
+    bool isError = false;       // Set by anything the parser let through that can't be compiled
 
     // LLVM stuff
     std::unique_ptr<LLVMContext> context;
     std::unique_ptr<Module> mod;
     std::unique_ptr<IRBuilder<>> builder;
+    std::unique_ptr<TargetMachine> targetMachine;
+    SmallVector<char, 0> objectBuffer;
     Function *currentFunc;
     AstDataType *currentFuncType;
     
-    // The user-defined structure table
-    std::map<std::string, StructType*> structTable;
-    std::map<std::string, std::string> structVarTable;
-    std::map<std::string, std::vector<Type *>> structElementTypeTable;
+    // The user-defined structure table, and the structure each struct variable holds
+    std::unordered_map<Symbol, StructType*> structTable;
+    std::unordered_map<Symbol, AstStruct *> structVarTable;
+    
+    // Translated data types, by canonical AST type
+    std::unordered_map<AstDataType *, Type *> typeCache;
     
     // Symbol table
-    std::map<std::string, AllocaInst *> symtable;
-    std::map<std::string, AstDataType *> typeTable;
+    // Like the parser's ScopeTable, each declaration logs what it shadowed, and a
+    // block puts it all back when it ends (a null entry wasn't declared)
+    struct Shadowed {
+        Symbol name;
+        AllocaInst *ptr;
+        AstDataType *type;
+        AstStruct *str;
+    };
+    
+    std::unordered_map<Symbol, AllocaInst *> symtable;
+    std::unordered_map<Symbol, AstDataType *> typeTable;
+    std::vector<Shadowed> undo;
     
     // Block stack
     int blockCount = 0;
@@ -5,6 +5,24 @@
 //
 #include "Compiler.hpp"
 
+// Compiles the body of an if/else or a loop, and returns false if it ends in a
+// jump. Anything declared in the block goes out of scope at the end (the parser
+// checks that), so the tables are put back in case a name was shadowed.
+bool Compiler::compileBlock(AstBlock *block) {
+    size_t scope = undo.size();
+    walk(block);
+    exitScope(scope);
+    
+    bool branchEnd = true;
+    for (auto stmt : block->getBlock()) {
+        if (stmt->getType() == V_AstType::Return) branchEnd = false;
+        if (stmt->getType() == V_AstType::Break) branchEnd = false;
+        if (stmt->getType() == V_AstType::Continue) branchEnd = false;
+    }
+    
+    return branchEnd;
+}
+
 // Translates an AST IF statement to LLVM
 void Compiler::compileIfStatement(AstStatement *stmt) {
     AstIfStmt *condStmt = static_cast<AstIfStmt *>(stmt);
@@ -19,7 +37,7 @@ void Compiler::compileIfStatement(AstStatement *stmt) {
     logicalOrStack.push(trueBlock);
     logicalAndStack.push(falseBlock);
     
-    Value *cond = compileValue(condStmt->getExpression());
+    Value *cond = toCondition(compileValue(condStmt->getExpression()));
     builder->CreateCondBr(cond, trueBlock, falseBlock);
     
     logicalAndStack.pop();
@@ -32,23 +50,11 @@ void Compiler::compileIfStatement(AstStatement *stmt) {
     
     // True block
     builder->SetInsertPoint(trueBlock);
-    bool branchEnd = true;
-    for (auto stmt2 : astTrueBlock->getBlock()) {
-        compileStatement(stmt2);
-        if (stmt2->getType() == V_AstType::Return) branchEnd = false;
-        if (stmt2->getType() == V_AstType::Break) branchEnd = false;
-    }
-    if (branchEnd) builder->CreateBr(endBlock);
+    if (compileBlock(astTrueBlock)) builder->CreateBr(endBlock);
     
     // False block
     builder->SetInsertPoint(falseBlock);
-    branchEnd = true;
-    for (auto stmt2 : astFalseBlock->getBlock()) {
-        compileStatement(stmt2);
-        if (stmt2->getType() == V_AstType::Return) branchEnd = false;
-        if (stmt2->getType() == V_AstType::Break) branchEnd = false;
-    }
-    if (branchEnd) builder->CreateBr(endBlock);
+    if (compileBlock(astFalseBlock)) builder->CreateBr(endBlock);
     
     // End block
     builder->SetInsertPoint(endBlock);
@@ -73,14 +79,11 @@ void Compiler::compileWhileStatement(AstStatement *stmt) {
 
     builder->CreateBr(loopCmp);
     builder->SetInsertPoint(loopCmp);
-    Value *cond = compileValue(stmt->getExpression());
+    Value *cond = toCondition(compileValue(stmt->getExpression()));
     builder->CreateCondBr(cond, loopBlock, loopEnd);
 
     builder->SetInsertPoint(loopBlock);
-    for (auto stmt : loop->getBlock()->getBlock()) {
-        compileStatement(stmt);
-    }
-    builder->CreateBr(loopCmp);
+    if (compileBlock(loop->getBlock())) builder->CreateBr(loopCmp);
     
     builder->SetInsertPoint(loopEnd);
     
@@ -11,13 +11,11 @@
 // Compiles a function and its body
 //
 void Compiler::compileFunction(AstGlobalStatement *global) {
-    symtable.clear();
-    typeTable.clear();
-    structVarTable.clear();
+    clearVars();
     
     AstFunction *astFunc = static_cast<AstFunction *>(global);
 
-    std::vector<Var> astVarArgs = astFunc->getArguments();
+    const std::vector<Var> &astVarArgs = astFunc->getArguments();
     FunctionType *FT;
     Type *funcType = translateType(astFunc->getDataType());
     currentFuncType = astFunc->getDataType();
@@ -37,7 +35,9 @@ void Compiler::compileFunction(AstGlobalStatement *global) {
         FT = FunctionType::get(funcType, args, false);
     }
     
-    Function *func = Function::Create(FT, Function::ExternalLinkage, astFunc->getName(), mod.get());
+    Function *func = Function::Create(FT, Function::ExternalLinkage, astFunc->getName().str(), mod.get());
+    func->addFnAttr("target-cpu", cflags.cpu);
+    if (cflags.features != "") func->addFnAttr("target-features", cflags.features);
     currentFunc = func;
 
     BasicBlock *mainBlock = BasicBlock::Create(*context, "entry", func);
@@ -51,15 +51,13 @@ void Compiler::compileFunction(AstGlobalStatement *global) {
             // Build the alloca for the local var
             Type *type = translateType(var.type);
             if (var.type->getType() == V_AstType::Struct) {
-                symtable[var.name] = (AllocaInst *)func->getArg(i);
-                typeTable[var.name] = var.type;
-                structVarTable[var.name] = static_cast<AstStructType *>(var.type)->getName();
+                AstStruct *str = tree->getStruct(static_cast<AstStructType *>(var.type)->getName());
+                declareVar(var.name, (AllocaInst *)func->getArg(i), var.type, str);
                 continue;
             }
             
-            AllocaInst *alloca = builder->CreateAlloca(type);
-            symtable[var.name] = alloca;
-            typeTable[var.name] = var.type;
+            AllocaInst *alloca = createEntryAlloca(type);
+            declareVar(var.name, alloca, var.type);
             
             // Store the variable
             Value *param = func->getArg(i);
@@ -67,9 +65,7 @@ void Compiler::compileFunction(AstGlobalStatement *global) {
         }
     }
 
-    for (auto stmt : astFunc->getBlock()->getBlock()) {
-        compileStatement(stmt);
-    }
+    walk(astFunc->getBlock());
 }
 
 //
@@ -78,7 +74,7 @@ void Compiler::compileFunction(AstGlobalStatement *global) {
 void Compiler::compileExternFunction(AstGlobalStatement *global) {
     AstExternFunction *astFunc = static_cast<AstExternFunction *>(global);
     
-    std::vector<Var> astVarArgs = astFunc->getArguments();
+    const std::vector<Var> &astVarArgs = astFunc->getArguments();
     FunctionType *FT;
     
     Type *retType = translateType(astFunc->getDataType());
@@ -95,7 +91,7 @@ void Compiler::compileExternFunction(AstGlobalStatement *global) {
         FT = FunctionType::get(retType, args, astFunc->isVarArgs());
     }
     
-    Function::Create(FT, Function::ExternalLinkage, astFunc->getName(), mod.get());
+    Function::Create(FT, Function::ExternalLinkage, astFunc->getName().str(), mod.get());
 }
 
 //
@@ -118,7 +114,7 @@ void Compiler::compileFuncCallStatement(AstStatement *stmt) {
         args.push_back(val);
     }
     
-    Function *callee = mod->getFunction(fc->getName());
+    Function *callee = mod->getFunction(fc->getName().str());
     if (!callee) std::cerr << "Invalid function call statement." << std::endl;
     builder->CreateCall(callee, args);
 }
@@ -132,7 +128,10 @@ void Compiler::compileReturnStatement(AstStatement *stmt) {
         builder->CreateRetVoid();
     } else if (stmt->hasExpression()) {
         Value *val = compileValue(stmt->getExpression());
-        if (currentFuncType->getType() == V_AstType::Struct) {
+        if (currentFuncType->getType() == V_AstType::Void) {
+            // The value is still evaluated, but a void function can't return it
+            builder->CreateRetVoid();
+        } else if (currentFuncType->getType() == V_AstType::Struct) {
             AstStructType *sType = static_cast<AstStructType *>(currentFuncType);
             StructType *type = structTable[sType->getName()];
             Value *ld = builder->CreateLoad(type, val);
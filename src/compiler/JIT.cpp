@@ -0,0 +1,142 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
+#include "llvm/ExecutionEngine/JITEventListener.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/Object/SymbolSize.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <iostream>
+#include <cstdio>
+#include <unistd.h>
+
+using namespace llvm;
+using namespace llvm::orc;
+
+#include "Compiler.hpp"
+
+// Writes each JITed function to /tmp/perf-<pid>.map, which is where perf looks
+// for symbols it can't find in a mapped file. The format is "<start> <size> <name>"
+// with the addresses in hex.
+class PerfMapListener : public JITEventListener {
+public:
+    explicit PerfMapListener() {
+        std::string path = "/tmp/perf-" + std::to_string(getpid()) + ".map";
+        file = fopen(path.c_str(), "a");
+    }
+
+    ~PerfMapListener() {
+        if (file) fclose(file);
+    }
+
+    void notifyObjectLoaded(ObjectKey, const object::ObjectFile &obj,
+                            const RuntimeDyld::LoadedObjectInfo &info) override {
+        if (!file) return;
+
+        // The debug object has the symbols at their final addresses
+        object::OwningBinary<object::ObjectFile> debugObj = info.getObjectForDebug(obj);
+        const object::ObjectFile &symObj = debugObj.getBinary() ? *debugObj.getBinary() : obj;
+
+        for (auto &pair : object::computeSymbolSizes(symObj)) {
+            object::SymbolRef sym = pair.first;
+
+            auto type = sym.getType();
+            if (!type) {
+                consumeError(type.takeError());
+                continue;
+            }
+            if (*type != object::SymbolRef::ST_Function) continue;
+
+            auto name = sym.getName();
+            auto address = sym.getAddress();
+            if (!name || !address) {
+                if (!name) consumeError(name.takeError());
+                if (!address) consumeError(address.takeError());
+                continue;
+            }
+
+            fprintf(file, "%llx %llx %s\n", (unsigned long long)*address,
+                    (unsigned long long)pair.second, name->str().c_str());
+        }
+        fflush(file);
+    }
+private:
+    FILE *file = nullptr;
+};
+
+// Runs the module in-process, and returns the exit code of main. The module
+// and its context are handed over to the JIT, so nothing can be emitted after this.
+int Compiler::run(std::vector<std::string> args) {
+    TargetMachine *machine = buildTargetMachine();
+    if (!machine) return 1;
+
+    // Use the same target as the object file path, so the data layout matches
+    JITTargetMachineBuilder jtmb(machine->getTargetTriple());
+    jtmb.setCPU(machine->getTargetCPU().str());
+    jtmb.addFeatures(std::vector<std::string>{machine->getTargetFeatureString().str()});
+    jtmb.setCodeGenOptLevel(machine->getOptLevel());
+
+    PerfMapListener perfMap;
+
+    auto jitOrError = LLJITBuilder()
+        .setJITTargetMachineBuilder(std::move(jtmb))
+        .setObjectLinkingLayerCreator([&](ExecutionSession &session, const Triple &) {
+            auto layer = std::make_unique<RTDyldObjectLinkingLayer>(session, []() {
+                return std::make_unique<SectionMemoryManager>();
+            });
+            layer->registerJITEventListener(perfMap);
+            return layer;
+        })
+        .create();
+    if (!jitOrError) {
+        errs() << "Error: Unable to create the JIT: " << toString(jitOrError.takeError()) << "\n";
+        return 1;
+    }
+    std::unique_ptr<LLJIT> jit = std::move(*jitOrError);
+
+    // The runtime comes from libtinylang, and anything else (malloc and friends)
+    // from whatever is already loaded into tlc
+    char prefix = jit->getDataLayout().getGlobalPrefix();
+    auto runtime = DynamicLibrarySearchGenerator::Load("libtinylang.so", prefix);
+    if (!runtime) {
+        errs() << "Error: Unable to load the runtime: " << toString(runtime.takeError()) << "\n";
+        return 1;
+    }
+    jit->getMainJITDylib().addGenerator(std::move(*runtime));
+
+    auto process = DynamicLibrarySearchGenerator::GetForCurrentProcess(prefix);
+    if (!process) {
+        errs() << "Error: " << toString(process.takeError()) << "\n";
+        return 1;
+    }
+    jit->getMainJITDylib().addGenerator(std::move(*process));
+
+    if (Error err = jit->addIRModule(ThreadSafeModule(std::move(mod), std::move(context)))) {
+        errs() << "Error: " << toString(std::move(err)) << "\n";
+        return 1;
+    }
+
+    auto mainSymbol = jit->lookup("main");
+    if (!mainSymbol) {
+        errs() << "Error: " << toString(mainSymbol.takeError()) << "\n";
+        return 1;
+    }
+
+    // Same convention as ti_start: main(args, argc), with a null-terminated args
+    std::vector<char *> argv;
+    for (auto &arg : args) argv.push_back(const_cast<char *>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    auto mainFunc = (int (*)(char **, int))mainSymbol->getAddress();
+    int code = mainFunc(argv.data(), (int)args.size());
+
+    // The runtime prints through iostreams
+    std::cout.flush();
+    fflush(stdout);
+    return code;
+}
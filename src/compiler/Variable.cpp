@@ -8,25 +8,60 @@
 #include "Compiler.hpp"
 #include <ast/ast_builder.hpp>
 
+// Adds a variable to the symbol table, logging whatever it shadows
+void Compiler::declareVar(Symbol name, AllocaInst *ptr, AstDataType *type, AstStruct *str) {
+    Shadowed shadowed;
+    shadowed.name = name;
+    
+    auto entry = symtable.find(name);
+    shadowed.ptr = (entry != symtable.end()) ? entry->second : nullptr;
+    auto typeEntry = typeTable.find(name);
+    shadowed.type = (typeEntry != typeTable.end()) ? typeEntry->second : nullptr;
+    auto structEntry = structVarTable.find(name);
+    shadowed.str = (structEntry != structVarTable.end()) ? structEntry->second : nullptr;
+    undo.push_back(shadowed);
+    
+    symtable[name] = ptr;
+    typeTable[name] = type;
+    if (str) structVarTable[name] = str;
+    else structVarTable.erase(name);
+}
+
+// Puts back whatever the declarations since start shadowed, newest first
+void Compiler::exitScope(size_t start) {
+    while (undo.size() > start) {
+        Shadowed &entry = undo.back();
+        
+        if (entry.ptr) symtable[entry.name] = entry.ptr;
+        else symtable.erase(entry.name);
+        if (entry.type) typeTable[entry.name] = entry.type;
+        else typeTable.erase(entry.name);
+        if (entry.str) structVarTable[entry.name] = entry.str;
+        else structVarTable.erase(entry.name);
+        
+        undo.pop_back();
+    }
+}
+
+void Compiler::clearVars() {
+    symtable.clear();
+    typeTable.clear();
+    structVarTable.clear();
+    undo.clear();
+}
+
 // Compiles a structure declaration
 void Compiler::compileStructDeclaration(AstStatement *stmt) {
     AstStructDec *sd = static_cast<AstStructDec *>(stmt);
     StructType *type1 = structTable[sd->getStructName()];
     PointerType *type = PointerType::getUnqual(type1);
     
-    AllocaInst *var = builder->CreateAlloca(type);
-    symtable[sd->getVarName()] = var;
-    typeTable[sd->getVarName()] = AstBuilder::buildStructType(sd->getStructName());
-    structVarTable[sd->getVarName()] = sd->getStructName();
-    
     // Find the corresponding AST structure
-    AstStruct *str = nullptr;
-    for (AstStruct *s : tree->getStructs()) {
-        if (s->getName() == sd->getStructName()) {
-            str = s;
-            break;
-        }
-    }
+    AstStruct *str = tree->getStruct(sd->getStructName());
+    
+    AllocaInst *var = createEntryAlloca(type);
+    declareVar(sd->getVarName(), var, AstBuilder::buildStructType(sd->getStructName()), str);
+    
     if (str == nullptr) return;
     
     // Create a malloc call
@@ -58,12 +93,29 @@ void Compiler::compileStructDeclaration(AstStatement *stmt) {
 // Compiles a structure access expression
 Value *Compiler::compileStructAccess(AstExpression *expr, bool isAssign) {
     AstStructAccess *sa = static_cast<AstStructAccess *>(expr);
+    
+    // The parser already rejects these; this only guards trees that were built
+    // some other way. Codegen carries on with a placeholder so every error is reported.
+    auto entry = structVarTable.find(sa->getName());
+    StructMember *member = nullptr;
+    if (entry == structVarTable.end()) {
+        errs() << "Error: " << sa->getName().str() << " is not a struct variable.\n";
+    } else if ((member = entry->second->getMember(sa->getMember())) == nullptr) {
+        errs() << "Error: " << entry->second->getName().str() << " has no member " << sa->getMember().str() << ".\n";
+    }
+    
+    if (member == nullptr) {
+        isError = true;
+        if (isAssign) return UndefValue::get(PointerType::getUnqual(*context));
+        return UndefValue::get(builder->getInt32Ty());
+    }
+    
+    AstStruct *str = entry->second;
     Value *ptr = symtable[sa->getName()];
-    int pos = getStructIndex(sa->getName(), sa->getMember());
+    int pos = member->index;
     
-    std::string strTypeName = structVarTable[sa->getName()];
-    StructType *strType = structTable[strTypeName];
-    Type *elementType = structElementTypeTable[strTypeName][pos];
+    StructType *strType = structTable[str->getName()];
+    Type *elementType = strType->getElementType(pos);
     
     // Load the structure pointer
     PointerType *strTypePtr = PointerType::getUnqual(strType);
@@ -6,364 +6,288 @@
 #include <iostream>
 
 #include <ast/ast.hpp>
-
-void AstTree::print() {
-    std::cout << "FILE: " << file << std::endl;
-    std::cout << std::endl;
-    
-    for (auto str : structs) str->print();
-    
-    for (auto stmt : global_statements) {
-        stmt->print();
-    }
-}
+#include <ast/Visitor.hpp>
 
 //
-// Data Types
+// Prints the tree for --ast
+// Where a node's text goes between its children (operators, argument lists,
+// and so on), the printer walks those children itself and skips the generic
+// walk; otherwise the walk does it, and leave() closes the node.
 //
-void AstDataType::print() {
-    if (_isUnsigned) std::cout << "unsigned ";
-
-    switch (type) {
-        case V_AstType::Void: std::cout << "void"; break;
-        case V_AstType::Bool: std::cout << "bool"; break;
-        case V_AstType::Char: std::cout << "char"; break;
-        case V_AstType::Int8: std::cout << "int8"; break;
-        case V_AstType::Int16: std::cout << "int16"; break;
-        case V_AstType::Int32: std::cout << "int32"; break;
-        case V_AstType::Int64: std::cout << "int64"; break;
-        case V_AstType::String: std::cout << "string"; break;
-        default: {}
-    }
-}
+class AstPrinter : public AstVisitor {
+protected:
+    bool visit(AstNode *node) override;
+    void leave(AstNode *node) override;
+private:
+    void printIndent();
+    void printArgs(const std::vector<Var> &args);
+    void printBinary(AstBinaryOp *op, const char *symbol);
+    
+    // The indent of the block being printed
+    int indent = 4;
+};
 
-void AstPointerType::print() {
-    std::cout << "*";
-    baseType->print();
+void AstTree::print() {
+    std::cout << "FILE: " << file << "\n";
+    std::cout << "\n";
+    
+    AstPrinter printer;
+    printer.walk(this);
+    std::cout << std::flush;
 }
 
-void AstStructType::print() {
-    std::cout << "struct(" << name << ")";
+void AstPrinter::printIndent() {
+    for (int i = 0; i<indent; i++) std::cout << " ";
 }
 
-//
-// Global types
-//
-void AstExternFunction::print() {
-    std::cout << "EXTERN FUNC " << name << "(";
+void AstPrinter::printArgs(const std::vector<Var> &args) {
     for (auto var : args) {
-        var.type->print();
+        walk(var.type);
         std::cout << ", ";
     }
-    std::cout << ") ";
-    std::cout << " -> ";
-    dataType->print();
-    std::cout << std::endl;
 }
 
-void AstFunction::print() {
-    std::cout << std::endl;
-    std::cout << "FUNC " << name << "(";
-    for (auto var : args) {
-        var.type->print();
-        std::cout << ", ";
-    }
-    std::cout << ") -> ";
-    dataType->print();
-    std::cout << std::endl;
-    
-    block->print();
+void AstPrinter::printBinary(AstBinaryOp *op, const char *symbol) {
+    std::cout << "(";
+    walk(op->getLVal());
+    std::cout << ") " << symbol << " (";
+    walk(op->getRVal());
+    std::cout << ")";
 }
 
-void AstBlock::print(int indent) {
-    for (int i = 0; i<indent; i++) std::cout << " ";
-    std::cout << "{" << std::endl;
-    
-    for (auto stmt : block) {
-        for (int i = 0; i<indent; i++) std::cout << " ";
-        switch (stmt->getType()) {
-            case V_AstType::If: {
-                static_cast<AstIfStmt *>(stmt)->print(indent);
-            } break;
-            case V_AstType::While: {
-                static_cast<AstWhileStmt *>(stmt)->print(indent);
-            } break;
+bool AstPrinter::visit(AstNode *node) {
+    switch (node->getType()) {
+        //
+        // Data Types
+        //
+        case V_AstType::Void:
+        case V_AstType::Bool:
+        case V_AstType::Char:
+        case V_AstType::Int8:
+        case V_AstType::Int16:
+        case V_AstType::Int32:
+        case V_AstType::Int64:
+        case V_AstType::String: {
+            if (static_cast<AstDataType *>(node)->isUnsigned()) std::cout << "unsigned ";
             
-            default: stmt->print();
-        }
-    }
-    
-    for (int i = 0; i<indent; i++) std::cout << " ";
-    std::cout << "}" << std::endl;
-}
-
-void AstStruct::print() {
-    std::cout << "STRUCT " << name << std::endl;
-    
-    for (auto var : items) {
-        std::cout << var.name << " : ";
-        var.type->print();
-        std::cout << " ";
-        defaultExpressions[var.name]->print();
-        std::cout << std::endl;
-    }
-    std::cout << std::endl;
-}
-
-void AstExprStatement::print() {
-    std::cout << "EXPR ";
-    if (dataType) dataType->print();
-    
-    std::cout << " ";
-    getExpression()->print();
-    std::cout << std::endl;
-}
-
-void AstFuncCallStmt::print() {
-    std::cout << "FC " << name;
-    getExpression()->print();
-    std::cout << std::endl;
-}
-
-void AstReturnStmt::print() {
-    std::cout << "RETURN ";
-    if (getExpression()) getExpression()->print();
-    std::cout << std::endl;
-}
-
-void AstVarDec::print() {
-    std::cout << "VAR_DEC " << name << " : ";
-    dataType->print();
-    if (dataType->getType() == V_AstType::Ptr) {
-        std::cout << "[";
-        size->print();
-        std::cout << "]";
+            switch (node->getType()) {
+                case V_AstType::Void: std::cout << "void"; break;
+                case V_AstType::Bool: std::cout << "bool"; break;
+                case V_AstType::Char: std::cout << "char"; break;
+                case V_AstType::Int8: std::cout << "int8"; break;
+                case V_AstType::Int16: std::cout << "int16"; break;
+                case V_AstType::Int32: std::cout << "int32"; break;
+                case V_AstType::Int64: std::cout << "int64"; break;
+                default: std::cout << "string";
+            }
+        } return false;
+        
+        // The walk prints the base type
+        case V_AstType::Ptr: std::cout << "*"; return true;
+        
+        case V_AstType::Struct: {
+            std::cout << "struct(" << static_cast<AstStructType *>(node)->getName() << ")";
+        } return false;
+        
+        //
+        // Global types
+        //
+        case V_AstType::ExternFunc: {
+            AstExternFunction *func = static_cast<AstExternFunction *>(node);
+            std::cout << "EXTERN FUNC " << func->getName() << "(";
+            printArgs(func->getArguments());
+            std::cout << ") ";
+            std::cout << " -> ";
+            walk(func->getDataType());
+            std::cout << "\n";
+        } return false;
+        
+        case V_AstType::Func: {
+            AstFunction *func = static_cast<AstFunction *>(node);
+            std::cout << "\n";
+            std::cout << "FUNC " << func->getName() << "(";
+            printArgs(func->getArguments());
+            std::cout << ") -> ";
+            walk(func->getDataType());
+            std::cout << "\n";
+            
+            indent = 4;
+            walk(func->getBlock());
+        } return false;
+        
+        case V_AstType::StructDef: {
+            AstStruct *str = static_cast<AstStruct *>(node);
+            std::cout << "STRUCT " << str->getName() << "\n";
+            
+            for (auto var : str->getItems()) {
+                std::cout << var.name << " : ";
+                walk(var.type);
+                std::cout << " ";
+                walk(str->getDefaultExpression(var.name));
+                std::cout << "\n";
+            }
+            std::cout << "\n";
+        } return false;
+        
+        case V_AstType::Block: {
+            printIndent();
+            std::cout << "{\n";
+        } return true;
+        
+        //
+        // Statements
+        // Each one starts on its own line, at the indent of its block
+        //
+        case V_AstType::ExprStmt: {
+            AstExprStatement *stmt = static_cast<AstExprStatement *>(node);
+            printIndent();
+            std::cout << "EXPR ";
+            walk(stmt->getDataType());
+            std::cout << " ";
+            walk(stmt->getExpression());
+            std::cout << "\n";
+        } return false;
+        
+        case V_AstType::FuncCallStmt: {
+            printIndent();
+            std::cout << "FC " << static_cast<AstFuncCallStmt *>(node)->getName();
+        } return true;
+        
+        case V_AstType::Return: {
+            printIndent();
+            std::cout << "RETURN ";
+        } return true;
+        
+        case V_AstType::VarDec: {
+            AstVarDec *vd = static_cast<AstVarDec *>(node);
+            printIndent();
+            std::cout << "VAR_DEC " << vd->getName() << " : ";
+            walk(vd->getDataType());
+            if (vd->getDataType()->getType() == V_AstType::Ptr) {
+                std::cout << "[";
+                walk(vd->getPtrSize());
+                std::cout << "]";
+            }
+            std::cout << "\n";
+        } return false;
+        
+        case V_AstType::StructDec: {
+            AstStructDec *sd = static_cast<AstStructDec *>(node);
+            printIndent();
+            std::cout << "STRUCT " << sd->getVarName() << " : " << sd->getStructName();
+            if (sd->isNoInit()) std::cout << " NOINIT";
+            std::cout << "\n";
+        } return false;
+        
+        case V_AstType::If: {
+            AstIfStmt *cond = static_cast<AstIfStmt *>(node);
+            printIndent();
+            std::cout << "IF ";
+            walk(cond->getExpression());
+            std::cout << " THEN\n";
+            
+            indent += 4;
+            walk(cond->getTrueBlock());
+            walk(cond->getFalseBlock());
+            indent -= 4;
+        } return false;
+        
+        case V_AstType::While: {
+            AstWhileStmt *loop = static_cast<AstWhileStmt *>(node);
+            printIndent();
+            std::cout << "WHILE ";
+            walk(loop->getExpression());
+            std::cout << " DO\n";
+            
+            indent += 4;
+            walk(loop->getBlock());
+            indent -= 4;
+        } return false;
+        
+        case V_AstType::Break: {
+            printIndent();
+            std::cout << "BREAK\n";
+        } return false;
+        
+        case V_AstType::Continue: {
+            printIndent();
+            std::cout << "CONTINUE\n";
+        } return false;
+        
+        //
+        // Expressions
+        //
+        case V_AstType::ExprList: {
+            std::cout << "{";
+            for (auto item : static_cast<AstExprList *>(node)->getList()) {
+                walk(item);
+                std::cout << ", ";
+            }
+            std::cout << "}";
+        } return false;
+        
+        case V_AstType::Neg: std::cout << "(-"; return true;
+        
+        case V_AstType::Assign: printBinary(static_cast<AstBinaryOp *>(node), ":="); return false;
+        case V_AstType::Add: printBinary(static_cast<AstBinaryOp *>(node), "+"); return false;
+        case V_AstType::Sub: printBinary(static_cast<AstBinaryOp *>(node), "-"); return false;
+        case V_AstType::Mul: printBinary(static_cast<AstBinaryOp *>(node), "*"); return false;
+        case V_AstType::Div: printBinary(static_cast<AstBinaryOp *>(node), "/"); return false;
+        case V_AstType::Mod: printBinary(static_cast<AstBinaryOp *>(node), "%"); return false;
+        case V_AstType::And: printBinary(static_cast<AstBinaryOp *>(node), "AND"); return false;
+        case V_AstType::Or: printBinary(static_cast<AstBinaryOp *>(node), "OR"); return false;
+        case V_AstType::Xor: printBinary(static_cast<AstBinaryOp *>(node), "XOR"); return false;
+        case V_AstType::EQ: printBinary(static_cast<AstBinaryOp *>(node), "=="); return false;
+        case V_AstType::NEQ: printBinary(static_cast<AstBinaryOp *>(node), "!="); return false;
+        case V_AstType::GT: printBinary(static_cast<AstBinaryOp *>(node), ">"); return false;
+        case V_AstType::LT: printBinary(static_cast<AstBinaryOp *>(node), "<"); return false;
+        case V_AstType::GTE: printBinary(static_cast<AstBinaryOp *>(node), ">="); return false;
+        case V_AstType::LTE: printBinary(static_cast<AstBinaryOp *>(node), "<="); return false;
+        case V_AstType::LogicalAnd: printBinary(static_cast<AstBinaryOp *>(node), "&&"); return false;
+        case V_AstType::LogicalOr: printBinary(static_cast<AstBinaryOp *>(node), "||"); return false;
+        
+        case V_AstType::CharL: std::cout << "CHAR(" << static_cast<AstChar *>(node)->getValue() << ")"; break;
+        case V_AstType::I8L: std::cout << static_cast<AstI8 *>(node)->getValue(); break;
+        case V_AstType::I16L: std::cout << static_cast<AstI16 *>(node)->getValue(); break;
+        case V_AstType::I32L: std::cout << static_cast<AstI32 *>(node)->getValue(); break;
+        case V_AstType::I64L: std::cout << static_cast<AstI64 *>(node)->getValue(); break;
+        case V_AstType::StringL: std::cout << "\"" << static_cast<AstString *>(node)->getValue() << "\""; break;
+        case V_AstType::ID: std::cout << static_cast<AstID *>(node)->getValue(); break;
+        
+        case V_AstType::ArrayAccess: {
+            std::cout << static_cast<AstArrayAccess *>(node)->getValue() << "[";
+        } return true;
+        
+        case V_AstType::StructAccess: {
+            AstStructAccess *sa = static_cast<AstStructAccess *>(node);
+            std::cout << sa->getName() << "." << sa->getMember();
+        } break;
+        
+        case V_AstType::FuncCallExpr: {
+            std::cout << static_cast<AstFuncCallExpr *>(node)->getName() << "(";
+        } return true;
+        
+        default: {}
     }
-    std::cout << std::endl;
-}
-
-void AstStructDec::print() {
-    std::cout << "STRUCT " << varName << " : " << structName;
-    if (noInit) std::cout << " NOINIT";
-    std::cout << std::endl;
-}
-
-void AstIfStmt::print(int indent) {
-    std::cout << "IF ";
-    getExpression()->print();
-    std::cout << " THEN" << std::endl;
-    trueBlock->print(indent+4);
-    falseBlock->print(indent+4);
-}
-
-void AstWhileStmt::print(int indent) {
-    std::cout << "WHILE ";
-    getExpression()->print();
-    std::cout << " DO" << std::endl;
     
-    block->print(indent+4);
-}
-
-void AstBreak::print() {
-    std::cout << "BREAK" << std::endl;
-}
-
-void AstContinue::print() {
-    std::cout << "CONTINUE" << std::endl;
-}
-
-void AstExprList::print() {
-    std::cout << "{";
-    for (auto item : list) {
-        item->print();
-        std::cout << ", ";
+    return false;
+}
+
+void AstPrinter::leave(AstNode *node) {
+    switch (node->getType()) {
+        case V_AstType::Block: {
+            printIndent();
+            std::cout << "}\n";
+        } break;
+        
+        case V_AstType::FuncCallStmt:
+        case V_AstType::Return: std::cout << "\n"; break;
+        
+        case V_AstType::Neg:
+        case V_AstType::FuncCallExpr: std::cout << ")"; break;
+        
+        case V_AstType::ArrayAccess: std::cout << "]"; break;
+        
+        default: {}
     }
-    std::cout << "}";
-}
-
-void AstNegOp::print() {
-    std::cout << "(-";
-    val->print();
-    std::cout << ")";
-}
-
-void AstAssignOp::print() {
-    std::cout << "(";
-    lval->print();
-    std::cout << ") := (";
-    rval->print();
-    std::cout << ")";
-}
-
-void AstAddOp::print() {
-    std::cout << "(";
-    lval->print();
-    std::cout << ") + (";
-    rval->print();
-    std::cout << ")";
-}
-
-void AstSubOp::print() {
-    std::cout << "(";
-    lval->print();
-    std::cout << ") - (";
-    rval->print();
-    std::cout << ")";
-}
-
-void AstMulOp::print() {
-    std::cout << "(";
-    lval->print();
-    std::cout << ") * (";
-    rval->print();
-    std::cout << ")";
-}
-
-void AstDivOp::print() {
-    std::cout << "(";
-    lval->print();
-    std::cout << ") / (";
-    rval->print();
-    std::cout << ")";
-}
-
-void AstModOp::print() {
-    std::cout << "(";
-    lval->print();
-    std::cout << ") % (";
-    rval->print();
-    std::cout << ")";
-}
-
-void AstAndOp::print() {
-    std::cout << "(";
-    lval->print();
-    std::cout << ") AND (";
-    rval->print();
-    std::cout << ")";
-}
-
-void AstOrOp::print() {
-    std::cout << "(";
-    lval->print();
-    std::cout << ") OR (";
-    rval->print();
-    std::cout << ")";
-}
-
-void AstXorOp::print() {
-    std::cout << "(";
-    lval->print();
-    std::cout << ") XOR (";
-    rval->print();
-    std::cout << ")";
-}
-
-void AstEQOp::print() {
-    std::cout << "(";
-    lval->print();
-    std::cout << ") == (";
-    rval->print();
-    std::cout << ")";
-}
-
-void AstNEQOp::print() {
-    std::cout << "(";
-    lval->print();
-    std::cout << ") != (";
-    rval->print();
-    std::cout << ")";
-}
-
-void AstGTOp::print() {
-    std::cout << "(";
-    lval->print();
-    std::cout << ") > (";
-    rval->print();
-    std::cout << ")";
-}
-
-void AstLTOp::print() {
-    std::cout << "(";
-    lval->print();
-    std::cout << ") < (";
-    rval->print();
-    std::cout << ")";
 }
-
-void AstGTEOp::print() {
-    std::cout << "(";
-    lval->print();
-    std::cout << ") >= (";
-    rval->print();
-    std::cout << ")";
-}
-
-void AstLTEOp::print() {
-    std::cout << "(";
-    lval->print();
-    std::cout << ") <= (";
-    rval->print();
-    std::cout << ")";
-}
-
-void AstLogicalAndOp::print() {
-    std::cout << "(";
-    lval->print();
-    std::cout << ") && (";
-    rval->print();
-    std::cout << ")";
-}
-
-void AstLogicalOrOp::print() {
-    std::cout << "(";
-    lval->print();
-    std::cout << ") || (";
-    rval->print();
-    std::cout << ")";
-}
-
-void AstChar::print() {
-    std::cout << "CHAR(" << val << ")";
-}
-
-void AstI8::print() {
-    std::cout << val;
-}
-
-void AstI16::print() {
-    std::cout << val;
-}
-
-void AstI32::print() {
-    std::cout << val;
-}
-
-void AstI64::print() {
-    std::cout << val;
-}
-
-void AstString::print() {
-    std::cout << "\"" << val << "\"";
-}
-
-void AstID::print() {
-    std::cout << val;
-}
-
-void AstArrayAccess::print() {
-    std::cout << val << "[";
-    index->print();
-    std::cout << "]";
-}
-
-void AstStructAccess::print() {
-    std::cout << var << "." << member;
-}
-
-void AstFuncCallExpr::print() {
-    std::cout << name << "(";
-    expr->print();
-    std::cout << ")";
-}
-
@@ -0,0 +1,179 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+// AstStats.cpp
+// Counts the nodes in a tree for --stats and the benchmark, and sizes up its flat form
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <set>
+
+#include <ast/ast.hpp>
+#include <ast/Visitor.hpp>
+#include <ast/FlatAst.hpp>
+
+static const char *getAstTypeName(V_AstType type) {
+    switch (type) {
+        case V_AstType::None: return "None";
+        case V_AstType::ExternFunc: return "ExternFunc";
+        case V_AstType::Func: return "Func";
+        case V_AstType::StructDef: return "StructDef";
+        case V_AstType::Block: return "Block";
+        case V_AstType::Return: return "Return";
+        case V_AstType::ExprStmt: return "ExprStmt";
+        case V_AstType::FuncCallStmt: return "FuncCallStmt";
+        case V_AstType::FuncCallExpr: return "FuncCallExpr";
+        case V_AstType::VarDec: return "VarDec";
+        case V_AstType::StructDec: return "StructDec";
+        case V_AstType::If: return "If";
+        case V_AstType::While: return "While";
+        case V_AstType::Break: return "Break";
+        case V_AstType::Continue: return "Continue";
+        case V_AstType::Neg: return "Neg";
+        case V_AstType::Assign: return "Assign";
+        case V_AstType::Add: return "Add";
+        case V_AstType::Sub: return "Sub";
+        case V_AstType::Mul: return "Mul";
+        case V_AstType::Div: return "Div";
+        case V_AstType::Mod: return "Mod";
+        case V_AstType::And: return "And";
+        case V_AstType::Or: return "Or";
+        case V_AstType::Xor: return "Xor";
+        case V_AstType::EQ: return "EQ";
+        case V_AstType::NEQ: return "NEQ";
+        case V_AstType::GT: return "GT";
+        case V_AstType::LT: return "LT";
+        case V_AstType::GTE: return "GTE";
+        case V_AstType::LTE: return "LTE";
+        case V_AstType::LogicalAnd: return "LogicalAnd";
+        case V_AstType::LogicalOr: return "LogicalOr";
+        case V_AstType::CharL: return "CharL";
+        case V_AstType::I8L: return "I8L";
+        case V_AstType::I16L: return "I16L";
+        case V_AstType::I32L: return "I32L";
+        case V_AstType::I64L: return "I64L";
+        case V_AstType::StringL: return "StringL";
+        case V_AstType::ID: return "ID";
+        case V_AstType::ArrayAccess: return "ArrayAccess";
+        case V_AstType::StructAccess: return "StructAccess";
+        case V_AstType::ExprList: return "ExprList";
+        case V_AstType::Void: return "Void";
+        case V_AstType::Bool: return "Bool";
+        case V_AstType::Char: return "Char";
+        case V_AstType::Int8: return "Int8";
+        case V_AstType::Int16: return "Int16";
+        case V_AstType::Int32: return "Int32";
+        case V_AstType::Int64: return "Int64";
+        case V_AstType::String: return "String";
+        case V_AstType::Ptr: return "Ptr";
+        case V_AstType::Struct: return "Struct";
+    }
+    return "";
+}
+
+// What each kind of node takes up
+static size_t getNodeSize(AstNode *node) {
+    switch (node->getType()) {
+        case V_AstType::ExternFunc: return sizeof(AstExternFunction);
+        case V_AstType::Func: return sizeof(AstFunction);
+        case V_AstType::StructDef: return sizeof(AstStruct);
+        case V_AstType::Block: return sizeof(AstBlock);
+        
+        case V_AstType::ExprStmt: return sizeof(AstExprStatement);
+        case V_AstType::VarDec: return sizeof(AstVarDec);
+        case V_AstType::If: return sizeof(AstIfStmt);
+        case V_AstType::While: return sizeof(AstWhileStmt);
+        case V_AstType::FuncCallStmt: return sizeof(AstFuncCallStmt);
+        case V_AstType::StructDec: return sizeof(AstStructDec);
+        case V_AstType::Return: return sizeof(AstReturnStmt);
+        case V_AstType::Break:
+        case V_AstType::Continue: return sizeof(AstStatement);
+        
+        case V_AstType::ExprList: return sizeof(AstExprList);
+        case V_AstType::Neg: return sizeof(AstNegOp);
+        
+        // All the binary operators have the same layout
+        case V_AstType::Assign:
+        case V_AstType::Add:
+        case V_AstType::Sub:
+        case V_AstType::Mul:
+        case V_AstType::Div:
+        case V_AstType::Mod:
+        case V_AstType::And:
+        case V_AstType::Or:
+        case V_AstType::Xor:
+        case V_AstType::EQ:
+        case V_AstType::NEQ:
+        case V_AstType::GT:
+        case V_AstType::LT:
+        case V_AstType::GTE:
+        case V_AstType::LTE:
+        case V_AstType::LogicalAnd:
+        case V_AstType::LogicalOr: return sizeof(AstBinaryOp);
+        
+        case V_AstType::CharL: return sizeof(AstChar);
+        case V_AstType::I8L: return sizeof(AstI8);
+        case V_AstType::I16L: return sizeof(AstI16);
+        case V_AstType::I32L: return sizeof(AstI32);
+        case V_AstType::I64L: return sizeof(AstI64);
+        case V_AstType::StringL: return sizeof(AstString);
+        case V_AstType::ID: return sizeof(AstID);
+        case V_AstType::ArrayAccess: return sizeof(AstArrayAccess);
+        case V_AstType::StructAccess: return sizeof(AstStructAccess);
+        case V_AstType::FuncCallExpr: return sizeof(AstFuncCallExpr);
+        
+        case V_AstType::Ptr: return sizeof(AstPointerType);
+        case V_AstType::Struct: return sizeof(AstStructType);
+        
+        default: {}
+    }
+    
+    // The rest of the data types
+    return sizeof(AstDataType);
+}
+
+// Types (and some expressions) are shared between nodes, so each node is only
+// counted the first time the walk reaches it
+class AstCounter : public AstVisitor {
+public:
+    std::set<AstNode *> seen;
+    std::map<V_AstType, size_t> counts;
+    std::map<V_AstType, size_t> bytes;
+protected:
+    bool visit(AstNode *node) override {
+        if (!seen.insert(node).second) return false;
+        counts[node->getType()] += 1;
+        bytes[node->getType()] += getNodeSize(node);
+        return true;
+    }
+};
+
+void AstTree::stats() {
+    AstCounter counter;
+    counter.walk(this);
+    
+    size_t totalCount = 0, totalBytes = 0;
+    
+    std::cerr << "AST nodes (" << file << "):" << std::endl;
+    for (auto entry : counter.counts) {
+        std::cerr << "  " << std::left << std::setw(16) << getAstTypeName(entry.first) << std::right
+            << std::setw(10) << entry.second << std::setw(12) << counter.bytes[entry.first] << " bytes" << std::endl;
+        totalCount += entry.second;
+        totalBytes += counter.bytes[entry.first];
+    }
+    std::cerr << "  " << std::left << std::setw(16) << "Total" << std::right
+        << std::setw(10) << totalCount << std::setw(12) << totalBytes << " bytes" << std::endl;
+    
+    // The same nodes, less the root, as 16-byte records and index lists
+    FlatAst flat(this);
+    std::cerr << "  " << std::left << std::setw(16) << "Flat form" << std::right
+        << std::setw(10) << (flat.size() - 1) << std::setw(12) << flat.getBytes() << " bytes" << std::endl;
+}
+
+size_t AstTree::countNodes() {
+    AstCounter counter;
+    counter.walk(this);
+    return counter.seen.size();
+}
@@ -0,0 +1,231 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+
+#include <lex/lex.hpp>
+#include <parser/Parser.hpp>
+#include <ast/Visitor.hpp>
+#include <ast/FlatAst.hpp>
+#include <driver/Bench.hpp>
+
+// Set by BenchAlloc.cpp, which only tlc-bench links in
+AllocationCounter *allocationCounter = nullptr;
+
+static void startCounting() {
+    if (!allocationCounter) return;
+    allocationCounter->count = 0;
+    allocationCounter->enabled = true;
+}
+
+static uint64_t stopCounting() {
+    if (!allocationCounter) return 0;
+    allocationCounter->enabled = false;
+    return allocationCounter->count;
+}
+
+struct BenchRun {
+    double seconds = 0;
+    uint64_t allocations = 0;
+    uint64_t tokens = 0;
+    uint64_t nodes = 0;
+    bool ok = true;
+};
+
+// Lexes the whole file, without following imports
+static BenchRun lexFile(Source *source) {
+    BenchRun run;
+    startCounting();
+    auto start = std::chrono::steady_clock::now();
+    
+    Scanner *scanner = new Scanner(source);
+    Token token = scanner->getNext();
+    while (token.type != Eof) {
+        ++run.tokens;
+        token = scanner->getNext();
+    }
+    delete scanner;
+    
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    run.allocations = stopCounting();
+    return run;
+}
+
+// Parses the file, including setting up the parser and its built-in functions
+static BenchRun parseFile(std::string input, bool countNodes) {
+    BenchRun run;
+    std::unique_ptr<Source> source = Source::open(input);
+    if (!source) {
+        run.ok = false;
+        return run;
+    }
+    
+    startCounting();
+    auto start = std::chrono::steady_clock::now();
+    
+    Parser *frontend = new Parser(std::move(source));
+    run.ok = frontend->parse();
+    
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    run.allocations = stopCounting();
+    
+    if (run.ok && countNodes) run.nodes = frontend->getTree()->countNodes();
+    
+    delete frontend->getTree();
+    delete frontend;
+    return run;
+}
+
+// Hash the kinds of node a walk reaches, in order, so the two walks can be
+// checked against each other (and the compiler can't drop them)
+class TreeWalkCounter : public AstVisitor {
+public:
+    uint64_t hash = 0;
+protected:
+    bool visit(AstNode *node) override {
+        hash = hash * 31 + (uint64_t)node->getType();
+        return true;
+    }
+};
+
+class FlatWalkCounter : public FlatAstVisitor {
+public:
+    uint64_t hash = 0;
+protected:
+    bool visit(const FlatAst &flat, uint32_t index) override {
+        hash = hash * 31 + (uint64_t)flat.getNode(index).type;
+        return true;
+    }
+};
+
+struct WalkRun {
+    double flatten = 0;
+    double tree = 0;        // Best of the runs, for each form
+    double flat = 0;
+    size_t treeBytes = 0;
+    size_t flatBytes = 0;
+    bool ok = true;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Parses the file once, then flattens the tree and times a full walk over each
+// form. Both walks reach the same nodes, so any difference is the layout.
+static WalkRun walkFile(std::string input, int runs) {
+    WalkRun run;
+    std::unique_ptr<Source> source = Source::open(input);
+    Parser *frontend = source ? new Parser(std::move(source)) : nullptr;
+    if (!frontend || !frontend->parse()) {
+        run.ok = false;
+        if (frontend) {
+            delete frontend->getTree();
+            delete frontend;
+        }
+        return run;
+    }
+    
+    AstTree *tree = frontend->getTree();
+    auto start = std::chrono::steady_clock::now();
+    FlatAst flat(tree);
+    run.flatten = secondsSince(start);
+    run.treeBytes = tree->getArena()->getSize();
+    run.flatBytes = flat.getBytes();
+    
+    for (int i = 0; i<runs; i++) {
+        TreeWalkCounter treeWalk;
+        start = std::chrono::steady_clock::now();
+        treeWalk.walk(tree);
+        double treeTime = secondsSince(start);
+        
+        FlatWalkCounter flatWalk;
+        start = std::chrono::steady_clock::now();
+        flatWalk.walk(flat);
+        double flatTime = secondsSince(start);
+        
+        if (treeWalk.hash != flatWalk.hash) run.ok = false;
+        if (i == 0 || treeTime < run.tree) run.tree = treeTime;
+        if (i == 0 || flatTime < run.flat) run.flat = flatTime;
+    }
+    
+    delete tree;
+    delete frontend;
+    return run;
+}
+
+// Rates are in millions per second
+static void printRate(std::string label, double count, double seconds, std::string unit) {
+    std::cout << "  " << std::left << std::setw(14) << label << std::right << std::fixed
+        << std::setprecision(0) << std::setw(12) << count
+        << std::setprecision(2) << std::setw(12) << (count / seconds / 1000000) << " " << unit << std::endl;
+}
+
+bool runBenchmark(std::string input, bool parse, int runs) {
+    std::unique_ptr<Source> source = Source::open(input);
+    if (!source) {
+        std::cerr << "Error: Unable to read " << input << "." << std::endl;
+        return false;
+    }
+    
+    // The warm-up run gives the token and node counts, which are the same every time
+    BenchRun totals = lexFile(source.get());
+    if (parse) {
+        BenchRun first = parseFile(input, true);
+        if (!first.ok) return false;
+        totals.nodes = first.nodes;
+    }
+    
+    double best = 0, total = 0;
+    uint64_t allocs = 0;
+    for (int i = 0; i<runs; i++) {
+        BenchRun run = parse ? parseFile(input, false) : lexFile(source.get());
+        if (!run.ok) return false;
+        
+        if (i == 0 || run.seconds < best) best = run.seconds;
+        total += run.seconds;
+        allocs = run.allocations;
+    }
+    
+    double size = source->getSize();
+    
+    std::cout << "Benchmark: " << (parse ? "parse " : "lex ") << input << " ("
+        << runs << " runs)" << std::endl;
+    std::cout << "  " << std::left << std::setw(14) << "Time" << std::right << std::fixed << std::setprecision(3)
+        << std::setw(12) << (best * 1000) << " ms best, " << (total / runs * 1000) << " ms mean" << std::endl;
+    printRate("Bytes", size, best, "MB/s");
+    printRate("Tokens", totals.tokens, best, "M/s");
+    if (parse) printRate("AST nodes", totals.nodes, best, "M/s");
+    
+    if (parse) {
+        WalkRun walk = walkFile(input, runs);
+        if (!walk.ok) {
+            std::cerr << "Error: The flat form and the tree walked differently." << std::endl;
+            return false;
+        }
+        
+        std::cout << std::setprecision(3);
+        std::cout << "  " << std::left << std::setw(14) << "Flatten" << std::right
+            << std::setw(12) << (walk.flatten * 1000) << " ms" << std::endl;
+        std::cout << "  " << std::left << std::setw(14) << "Walk (tree)" << std::right
+            << std::setw(12) << (walk.tree * 1000) << " ms best, " << walk.treeBytes << " bytes in the arena" << std::endl;
+        std::cout << "  " << std::left << std::setw(14) << "Walk (flat)" << std::right
+            << std::setw(12) << (walk.flat * 1000) << " ms best, " << walk.flatBytes << " bytes" << std::endl;
+    }
+    
+    if (allocationCounter) {
+        std::cout << "  " << std::left << std::setw(14) << "Allocations" << std::right << std::setw(12) << allocs
+            << std::setprecision(2) << std::setw(12) << ((double)allocs / std::max<uint64_t>(totals.tokens, 1)) << " per token" << std::endl;
+    } else {
+        std::cout << "  " << std::left << std::setw(14) << "Allocations" << std::right << std::setw(12) << "-"
+            << "  (counted by tlc-bench only)" << std::endl;
+    }
+    std::cout.unsetf(std::ios::fixed);
+    return true;
+}
@@ -0,0 +1,36 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+//
+// The frontend benchmark for --bench=lex and --bench=parse
+// The input is lexed (or lexed and parsed) once to warm up the page cache and
+// the header cache, and then timed over a number of runs. The rates come from
+// the fastest run, which is the most stable number to compare between builds.
+// gen-bench.py makes inputs big enough to be worth timing.
+//
+// The parse benchmark also flattens the tree (see FlatAst.hpp), and times a
+// full walk over the pointer tree and over the flat form.
+//
+// Allocations are only counted by tlc-bench, which is tlc with a replacement
+// global operator new (BenchAlloc.cpp). tlc itself keeps the standard one.
+//
+
+// The counter BenchAlloc.cpp registers; null in tlc
+struct AllocationCounter {
+    std::atomic<bool> enabled{false};
+    std::atomic<uint64_t> count{0};
+};
+
+extern AllocationCounter *allocationCounter;
+
+// Runs the benchmark on one file, and prints the results to stdout.
+// Returns false if the file can't be read or doesn't parse.
+bool runBenchmark(std::string input, bool parse, int runs);
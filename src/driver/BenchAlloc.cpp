@@ -0,0 +1,46 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#include <new>
+#include <cstdlib>
+
+#include <driver/Bench.hpp>
+
+//
+// Allocation counting for tlc-bench
+// The global operator new is replaced so every allocation can be counted. It
+// only counts while a benchmark run is going, so the rest of the time it costs
+// one load. The counter is constant-initialized, so it works before main.
+//
+static AllocationCounter counter;
+static bool registered = (allocationCounter = &counter, true);
+
+void *operator new(size_t size) {
+    if (counter.enabled.load(std::memory_order_relaxed)) {
+        counter.count.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    void *ptr = malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+// The nothrow form has to be replaced too, so everything that reaches the
+// operator delete below came from malloc
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    if (counter.enabled.load(std::memory_order_relaxed)) {
+        counter.count.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    return malloc(size ? size : 1);
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    free(ptr);
+}
@@ -0,0 +1,215 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <unistd.h>
+#include <utime.h>
+#include <link.h>
+#include <elf.h>
+#include <string.h>
+
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/ADT/StringExtras.h"
+
+#include <driver/Cache.hpp>
+
+using namespace llvm;
+
+// Finds the linker's build ID note in the running executable. The linker
+// hashes the whole output for it, so it changes whenever any of tlc does.
+static int findBuildId(struct dl_phdr_info *info, size_t, void *data) {
+    std::string *buildId = static_cast<std::string *>(data);
+    
+    // The executable is always the first object
+    for (int i = 0; i<info->dlpi_phnum; i++) {
+        const ElfW(Phdr) &phdr = info->dlpi_phdr[i];
+        if (phdr.p_type != PT_NOTE) continue;
+        
+        const char *pos = reinterpret_cast<const char *>(info->dlpi_addr + phdr.p_vaddr);
+        const char *end = pos + phdr.p_memsz;
+        while (pos + sizeof(ElfW(Nhdr)) <= end) {
+            const ElfW(Nhdr) *note = reinterpret_cast<const ElfW(Nhdr) *>(pos);
+            const char *name = pos + sizeof(ElfW(Nhdr));
+            const char *desc = name + ((note->n_namesz + 3) & ~3);
+            if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4 && memcmp(name, "GNU", 4) == 0) {
+                *buildId = toHex(StringRef(desc, note->n_descsz), true);
+                return 1;
+            }
+            pos = desc + ((note->n_descsz + 3) & ~3);
+        }
+    }
+    return 1;
+}
+
+// There is no release numbering yet, so the compiler is identified by its
+// build ID, or failing that, by a hash of the executable itself. Either way a
+// rebuilt compiler never reuses old objects, and two identical builds share them.
+static std::string getCompilerVersion() {
+    static std::string version = []() {
+        std::string buildId = "";
+        dl_iterate_phdr(findBuildId, &buildId);
+        
+        if (buildId == "") {
+            std::string exe = sys::fs::getMainExecutable(nullptr, (void *)&getCompilerVersion);
+            auto buffer = MemoryBuffer::getFile(exe);
+            if (buffer) buildId = toHex(SHA1::hash(arrayRefFromStringRef((*buffer)->getBuffer())), true);
+        }
+        
+        return "tlc " + buildId + " llvm " LLVM_VERSION_STRING;
+    }();
+    return version;
+}
+
+// Hashes the compiler build, the codegen flags and the given sources. The
+// kind keeps unit keys and object keys apart even for a unit with no imports.
+static std::string hashSources(std::string kind, std::vector<Source *> sources, CFlags flags) {
+    SHA1 hash;
+    auto addField = [&](std::string field) {
+        hash.update(field);
+        hash.update(StringRef("\0", 1));
+    };
+    
+    addField(kind);
+    addField(getCompilerVersion());
+    addField(std::to_string(flags.optLevel));
+    addField(flags.optSize ? "Os" : "");
+    addField(flags.cpu);
+    addField(flags.features);
+    addField(flags.externalTools ? "external" : "");
+    for (Source *source : sources) {
+        addField(std::to_string(source->getSize()));
+        hash.update(StringRef(source->getData(), source->getSize()));
+    }
+    
+    return toHex(hash.final(), true);
+}
+
+std::string getCacheKey(std::vector<Source *> sources, CFlags flags) {
+    return hashSources("object", sources, flags);
+}
+
+std::string getUnitKey(Source *source, CFlags flags) {
+    return hashSources("unit", { source }, flags);
+}
+
+bool fetchFromCache(std::string cacheDir, std::string key, std::string outPath) {
+    std::string entry = cacheDir + "/" + key + ".o";
+    if (!sys::fs::exists(entry)) return false;
+    if (sys::fs::copy_file(entry, outPath)) return false;
+    
+    // Mark the entry as recently used
+    utime(entry.c_str(), nullptr);
+    return true;
+}
+
+bool fetchUnitFromCache(std::string cacheDir, std::string unitKey, Source *source, CFlags flags,
+                        std::string outPath, std::vector<std::string> &headers) {
+    std::ifstream manifest(cacheDir + "/" + unitKey + ".deps");
+    if (!manifest.is_open()) return false;
+    
+    std::vector<std::string> paths;
+    std::string line = "";
+    while (std::getline(manifest, line)) {
+        if (line != "") paths.push_back(line);
+    }
+    
+    // The headers are hashed as they are now; one that's gone is a miss
+    std::vector<std::unique_ptr<Source>> headerSources;
+    std::vector<Source *> sources = { source };
+    for (std::string path : paths) {
+        std::unique_ptr<Source> header = Source::open(path);
+        if (!header) return false;
+        sources.push_back(header.get());
+        headerSources.push_back(std::move(header));
+    }
+    
+    if (!fetchFromCache(cacheDir, getCacheKey(sources, flags), outPath)) return false;
+    headers = paths;
+    return true;
+}
+
+// Drops the least recently used entries until the cache fits in maxSize
+static void evict(std::string cacheDir, uint64_t maxSize) {
+    struct Entry {
+        std::string path;
+        uint64_t size;
+        sys::TimePoint<> lastUsed;
+    };
+    
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    
+    std::error_code error;
+    for (sys::fs::directory_iterator it(cacheDir, error), end; it != end && !error; it.increment(error)) {
+        StringRef extension = sys::path::extension(it->path());
+        if (extension != ".o" && extension != ".deps") continue;
+        
+        sys::fs::file_status status;
+        if (sys::fs::status(it->path(), status)) continue;
+        
+        entries.push_back({ it->path(), status.getSize(), status.getLastModificationTime() });
+        total += status.getSize();
+    }
+    
+    if (total <= maxSize) return;
+    
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.lastUsed < b.lastUsed;
+    });
+    
+    for (auto &entry : entries) {
+        if (total <= maxSize) break;
+        if (!sys::fs::remove(entry.path)) total -= entry.size;
+    }
+}
+
+void storeInCache(std::string cacheDir, std::string key, std::string objPath, uint64_t maxSize) {
+    static std::mutex evictLock;
+    static std::atomic<int> tempCount(0);
+    
+    if (sys::fs::create_directories(cacheDir)) return;
+    
+    // Copy under a temporary name first, so nobody can pick up a partial object
+    std::string entry = cacheDir + "/" + key + ".o";
+    std::string temp = entry + "." + std::to_string(getpid()) + "." + std::to_string(tempCount++) + ".tmp";
+    if (sys::fs::copy_file(objPath, temp)) return;
+    if (sys::fs::rename(temp, entry)) {
+        sys::fs::remove(temp);
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(evictLock);
+    evict(cacheDir, maxSize);
+}
+
+void storeManifest(std::string cacheDir, std::string unitKey, std::vector<std::string> headers) {
+    static std::atomic<int> tempCount(0);
+    
+    if (sys::fs::create_directories(cacheDir)) return;
+    
+    // Written under a temporary name first, like the objects
+    std::string entry = cacheDir + "/" + unitKey + ".deps";
+    std::string temp = entry + "." + std::to_string(getpid()) + "." + std::to_string(tempCount++) + ".tmp";
+    {
+        std::ofstream writer(temp);
+        if (!writer.is_open()) return;
+        for (std::string header : headers) writer << header << "\n";
+        if (!writer) {
+            writer.close();
+            sys::fs::remove(temp);
+            return;
+        }
+    }
+    
+    if (sys::fs::rename(temp, entry)) sys::fs::remove(temp);
+}
@@ -0,0 +1,45 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <vector>
+
+#include <compiler/Compiler.hpp>
+#include <lex/Source.hpp>
+
+//
+// The object cache
+// Objects are stored under a hash of everything that goes into them: the source
+// and every header it imported, the compiler build, and the codegen flags. Once
+// the cache goes over its size limit, the least recently used entries go first.
+//
+// Which headers a unit imports is only known once it's parsed, so next to each
+// object goes a manifest, keyed by the unit's own source and flags, listing the
+// headers it imported. A lookup reads the manifest and hashes the headers as
+// they are now, so a hit never has to parse anything.
+//
+
+// Returns the cache key for a unit, given its source and imports
+std::string getCacheKey(std::vector<Source *> sources, CFlags flags);
+
+// Returns the key of a unit's manifest, from its own source alone
+std::string getUnitKey(Source *source, CFlags flags);
+
+// Copies a cached object to outPath. Returns false on a miss
+bool fetchFromCache(std::string cacheDir, std::string key, std::string outPath);
+
+// Looks a unit up through its manifest, before parsing. On a hit, the object is
+// copied to outPath and headers is set to what the unit imports
+bool fetchUnitFromCache(std::string cacheDir, std::string unitKey, Source *source, CFlags flags,
+                        std::string outPath, std::vector<std::string> &headers);
+
+// Records the headers a unit imported under its unit key
+void storeManifest(std::string cacheDir, std::string unitKey, std::vector<std::string> headers);
+
+// Adds an object to the cache, and evicts old entries to stay under maxSize bytes
+void storeInCache(std::string cacheDir, std::string key, std::string objPath, uint64_t maxSize);
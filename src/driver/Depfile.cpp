@@ -0,0 +1,58 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#include <iostream>
+#include <fstream>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <driver/Depfile.hpp>
+
+// Escapes a path the way make wants it
+static std::string escapePath(std::string path) {
+    std::string escaped = "";
+    for (char c : path) {
+        switch (c) {
+            case ' ':
+            case '#': escaped += '\\'; break;
+            case '$': escaped += '$'; break;
+            default: {}
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+bool writeDepfile(std::string path, std::string target, std::vector<std::string> deps) {
+    std::ofstream writer(path, std::ios_base::out | std::ios_base::trunc);
+    if (!writer.is_open()) {
+        std::cerr << "Error: Unable to write dependency file: " << path << std::endl;
+        return false;
+    }
+    
+    writer << escapePath(target) << ":";
+    for (std::string dep : deps) {
+        writer << " \\\n  " << escapePath(dep);
+    }
+    writer << std::endl;
+    
+    // A depfile cut short (by a full disk, say) would be trusted by make, so
+    // don't leave one behind. -MF can name a device too, which must stay put.
+    writer.close();
+    if (writer.fail()) {
+        std::cerr << "Error: Unable to write dependency file: " << path << std::endl;
+        struct stat info;
+        if (stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode)) unlink(path.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string getDepfilePath(std::string output) {
+    if (output.length() > 2 && output.substr(output.length() - 2) == ".o") {
+        return output.substr(0, output.length() - 2) + ".d";
+    }
+    return output + ".d";
+}
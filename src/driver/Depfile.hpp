@@ -0,0 +1,22 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#pragma once
+
+#include <string>
+#include <vector>
+
+//
+// Dependency files for -MD/-MF
+// These are make rules with no recipe ("target: dep dep..."), which make and
+// ninja (deps = gcc) both read, so a build only reruns tlc when the source or
+// one of the headers it imported changed.
+//
+
+// Writes a depfile; returns false if it can't be written
+bool writeDepfile(std::string path, std::string target, std::vector<std::string> deps);
+
+// Returns the default depfile path for an output (foo.o -> foo.d, a.out -> a.out.d)
+std::string getDepfilePath(std::string output);
@@ -0,0 +1,562 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+#include <unistd.h>
+
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/FileSystem.h"
+
+#include <preproc/Preproc.hpp>
+#include <parser/Parser.hpp>
+#include <parser/Module.hpp>
+#include <ast/ast.hpp>
+#include <ast/ast_builder.hpp>
+
+#include <compiler/Compiler.hpp>
+#include <driver/Driver.hpp>
+#include <driver/Cache.hpp>
+#include <driver/Timing.hpp>
+#include <driver/Depfile.hpp>
+#include <driver/Bench.hpp>
+
+// Driver flags (the codegen flags live in CFlags)
+struct DriverFlags {
+    bool emitPreproc = false;
+    bool testLex = false;
+    bool printAst = false;
+    bool emitDot = false;
+    bool printLLVM = false;
+    bool emitLLVM = false;
+    bool compileOnly = false;
+    bool hasOutput = false;
+    int jobs = 0;
+    std::string cacheDir = "";
+    uint64_t cacheSize = 1024;      // In MB
+    bool timeReport = false;
+    std::string traceFile = "";
+    bool stats = false;
+    bool emitModule = false;
+    bool writeDeps = false;         // -MD
+    std::string depFile = "";       // -MF
+    bool run = false;
+    std::vector<std::string> runArgs;   // Everything after --, with the input as args[0]
+    int runResult = 0;
+    std::string bench = "";         // "lex" or "parse"
+    int benchRuns = 10;
+    std::string tempDir = "";       // Private to this build; see makeTempDir()
+};
+
+// TODO: I'm not sure actually if the lex testing actually works
+//
+AstTree *getAstTree(Parser *frontend, std::string input, bool testLex, bool printAst, bool emitDot, bool stats, bool &isError) {
+    AstTree *tree;
+    
+    if (testLex) {
+        frontend->debugScanner();
+        isError = false;
+        return nullptr;
+    }
+    
+    // The scanner is driven by the parser, so lexing is counted here too
+    PhaseTimer timer("Parse", input);
+    if (!frontend->parse()) {
+        isError = true;
+        return nullptr;
+    }
+    
+    tree = frontend->getTree();
+    
+    if (stats) {
+        tree->stats();
+        std::cerr << "AST data types: " << AstBuilder::getTypeCount() << " requested, "
+            << AstBuilder::getDistinctTypeCount(tree->getArena().get()) << " distinct" << std::endl;
+        std::cerr << "AST arena: " << tree->getArena()->getSize() << " bytes" << std::endl;
+    }
+    
+    if (printAst) {
+        tree->print();
+        return nullptr;
+    }
+    
+    if (emitDot) {
+        tree->dot();
+        return nullptr;
+    }
+    
+    return tree;
+}
+
+// Returns the name of an input file without its directory or extension
+std::string getBaseName(std::string input) {
+    std::string name = input;
+    size_t slash = name.find_last_of('/');
+    if (slash != std::string::npos) name = name.substr(slash + 1);
+    
+    size_t dot = name.find_last_of('.');
+    if (dot != std::string::npos) name = name.substr(0, dot);
+    
+    return name;
+}
+
+// Makes a directory for the temporary files of this build. Each unit's files are
+// named by its index in it, so two units with the same name can't overwrite each
+// other's, and neither can other tlc processes or other jobs on the server
+bool makeTempDir(DriverFlags &dflags) {
+    const char *tmp = getenv("TMPDIR");
+    std::string path = "/tmp";
+    if (tmp != nullptr && tmp[0] != 0) path = tmp;
+    path += "/tlc-XXXXXX";
+    
+    if (mkdtemp(&path[0]) == nullptr) {
+        std::cerr << "Error: Unable to create a temporary directory in " << path << "." << std::endl;
+        return false;
+    }
+    
+    dflags.tempDir = path;
+    return true;
+}
+
+// Compiles a tree down to an object file at objPath (or runs it, with --run).
+// tempBase is where any other files (the assembly) go, without the extension
+int compileLLVM(AstTree *tree, CFlags flags, std::string objPath, std::string tempBase, DriverFlags &dflags) {
+    Compiler *compiler = new Compiler(tree, flags);
+    {
+        PhaseTimer timer("Codegen", objPath);
+        if (!compiler->compile()) {
+            delete compiler;
+            return 1;
+        }
+    }
+    if (dflags.stats) compiler->stats("Codegen");
+    
+    bool optimized = false;
+    {
+        PhaseTimer timer("Optimize", objPath);
+        optimized = compiler->optimize();
+    }
+    if (dflags.stats && optimized) compiler->stats("Optimize");
+    
+    // The JIT takes the module, so this skips emitting anything
+    if (optimized && dflags.run) {
+        PhaseTimer timer("Run", objPath);
+        dflags.runResult = compiler->run(dflags.runArgs);
+        delete compiler;
+        return 0;
+    }
+    
+    PhaseTimer timer("Emit", objPath);
+    int code = 0;
+    if (!optimized) {
+        code = 1;
+    } else if (dflags.printLLVM) {
+        compiler->debug();
+    } else if (dflags.emitLLVM) {
+        std::string output = flags.name;
+        if (output == "a.out") {
+            output = "./out.ll";
+        }
+            
+        compiler->emitLLVM(output);
+    } else if (flags.externalTools) {
+        std::string asmPath = tempBase + ".asm";
+        compiler->writeAssembly(asmPath);
+        
+        PhaseTimer timer("Assemble", objPath);
+        compiler->assemble(asmPath, objPath);
+    } else if (!compiler->writeObject() || !compiler->writeObjectFile(objPath)) {
+        code = 1;
+    }
+    
+    delete compiler;
+    return code;
+}
+
+// Runs a single input through the whole pipeline. On success, objPath is set
+// to the object to link, or left empty if there is nothing to link. deps gets
+// the input and every header it imported. index is the unit's place on the
+// command line, which names its temporary files
+int compileUnit(std::string input, size_t index, std::string &objPath, std::vector<std::string> &deps, CFlags flags, DriverFlags &dflags) {
+    // Objects given on the command line go straight to the link
+    if (input.length() > 2 && input.substr(input.length() - 2) == ".o") {
+        objPath = input;
+        return 0;
+    }
+    
+    std::string tempBase = dflags.tempDir + "/" + std::to_string(index) + "-" + getBaseName(input);
+    std::string outPath = tempBase + ".o";
+    if (dflags.compileOnly) {
+        if (dflags.hasOutput) outPath = flags.name;
+        else outPath = getBaseName(input) + ".o";
+    }
+    
+    // -E prints the file with its imports pasted in, and then carries on
+    if (dflags.emitPreproc) {
+        PhaseTimer timer("Preprocess", input);
+        std::string content = "";
+        if (!preprocessFile(input, content)) return 1;
+        std::cout << content << std::endl;
+    }
+    
+    std::unique_ptr<Source> source = Source::open(input);
+    if (!source) {
+        std::cout << "Unknown input file." << std::endl;
+        return 1;
+    }
+    
+    // Check the cache; on a hit, we don't need to parse or run LLVM at all. The
+    // unit's manifest says which headers to hash along with it
+    std::string unitKey = "";
+    bool noOutput = dflags.testLex || dflags.printAst || dflags.emitDot || dflags.printLLVM || dflags.emitLLVM || dflags.run;
+    if (dflags.cacheDir != "" && !noOutput) {
+        PhaseTimer timer("Cache lookup", input);
+        unitKey = getUnitKey(source.get(), flags);
+        
+        std::vector<std::string> headers;
+        if (fetchUnitFromCache(dflags.cacheDir, unitKey, source.get(), flags, outPath, headers)) {
+            deps.push_back(input);
+            for (std::string header : headers) deps.push_back(header);
+            objPath = outPath;
+            return 0;
+        }
+    }
+    
+    AstBuilder::resetTypeCount();      // The parser builds the builtin declarations up front
+    Parser *frontend = new Parser(std::move(source));
+    
+    bool isError = false;
+    AstTree *tree = getAstTree(frontend, input, dflags.testLex, dflags.printAst, dflags.emitDot, dflags.stats, isError);
+    if (tree == nullptr) {
+        delete frontend->getTree();
+        delete frontend;
+        if (isError) return 1;
+        return 0;
+    }
+    
+    deps.push_back(input);
+    std::vector<std::string> headers = frontend->getHeaderPaths();
+    for (std::string header : headers) deps.push_back(header);
+    
+    // The object's key needs the headers, which are only all known now
+    std::string cacheKey = "";
+    if (unitKey != "") cacheKey = getCacheKey(frontend->getSources(), flags);
+    
+    delete frontend;
+    
+    int code = compileLLVM(tree, flags, outPath, tempBase, dflags);
+    delete tree;
+    if (code != 0) return 1;
+    if (noOutput) return 0;
+    
+    objPath = outPath;
+    if (cacheKey != "") {
+        PhaseTimer timer("Cache store", input);
+        storeInCache(dflags.cacheDir, cacheKey, outPath, dflags.cacheSize * 1024 * 1024);
+        storeManifest(dflags.cacheDir, unitKey, headers);
+    }
+    return 0;
+}
+
+// Parses a whole number argument in [min, max]. The server runs the driver for
+// every client, so a bad command line has to be an error, never an exception
+bool parseNumber(std::string option, std::string text, long long min, long long max, long long &value) {
+    errno = 0;
+    char *end = nullptr;
+    value = strtoll(text.c_str(), &end, 10);
+    
+    if (text == "" || *end != 0 || errno == ERANGE || value < min || value > max) {
+        std::cerr << "Error: Invalid number for " << option << ": \"" << text << "\"" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Checks that an option which takes the next argument has one
+bool hasValue(std::vector<std::string> &args, size_t i) {
+    if (i + 1 < args.size()) return true;
+    std::cerr << "Error: " << args[i] << " needs an argument." << std::endl;
+    return false;
+}
+
+int runDriver(std::vector<std::string> args) {
+    if (args.size() == 0) {
+        std::cerr << "Error: No input file specified." << std::endl;
+        return 1;
+    }
+    
+    // Compiler (codegen) flags
+    CFlags flags;
+    flags.name = "a.out";
+    
+    // Other flags
+    DriverFlags dflags;
+    std::vector<std::string> inputs;
+    
+    const char *cacheEnv = getenv("TLC_CACHE_DIR");
+    if (cacheEnv != nullptr) dflags.cacheDir = cacheEnv;
+    
+    for (size_t i = 0; i<args.size(); i++) {
+        std::string arg = args[i];
+        
+        if (arg == "-E") {
+            dflags.emitPreproc = true;
+        } else if (arg == "--test-lex") {
+            dflags.testLex = true;
+        } else if (arg == "--ast") {
+            dflags.printAst = true;
+        } else if (arg == "--dot") {
+            dflags.emitDot = true;
+        } else if (arg == "--llvm") {
+            dflags.printLLVM = true;
+        } else if (arg == "--emit-llvm") {
+            dflags.emitLLVM = true;
+        } else if (arg == "-c") {
+            dflags.compileOnly = true;
+        } else if (arg == "-j") {
+            long long jobs = 0;
+            if (!hasValue(args, i) || !parseNumber(arg, args[i+1], 0, INT_MAX, jobs)) return 1;
+            dflags.jobs = jobs;
+            i += 1;
+        } else if (arg.find("-j") == 0) {
+            long long jobs = 0;
+            if (!parseNumber("-j", arg.substr(2), 0, INT_MAX, jobs)) return 1;
+            dflags.jobs = jobs;
+        } else if (arg.find("--cache-dir=") == 0) {
+            dflags.cacheDir = arg.substr(12);
+        } else if (arg.find("--cache-size=") == 0) {
+            // In MB; the limit keeps the size in bytes from overflowing
+            long long size = 0;
+            if (!parseNumber("--cache-size", arg.substr(13), 0, LLONG_MAX >> 20, size)) return 1;
+            dflags.cacheSize = size;
+        } else if (arg == "-ftime-report") {
+            dflags.timeReport = true;
+            flags.timePasses = true;
+        } else if (arg == "-MD") {
+            dflags.writeDeps = true;
+        } else if (arg == "-MF") {
+            if (!hasValue(args, i)) return 1;
+            dflags.writeDeps = true;
+            dflags.depFile = args[i+1];
+            i += 1;
+        } else if (arg.find("-MF") == 0) {
+            dflags.writeDeps = true;
+            dflags.depFile = arg.substr(3);
+        } else if (arg == "--emit-module") {
+            dflags.emitModule = true;
+        } else if (arg == "--run") {
+            dflags.run = true;
+        } else if (arg == "--" && dflags.run) {
+            // The rest goes to the program
+            dflags.runArgs.insert(dflags.runArgs.end(), args.begin() + i + 1, args.end());
+            break;
+        } else if (arg.find("--bench=") == 0) {
+            dflags.bench = arg.substr(8);
+        } else if (arg.find("--bench-runs=") == 0) {
+            long long runs = 0;
+            if (!parseNumber("--bench-runs", arg.substr(13), 0, INT_MAX, runs)) return 1;
+            dflags.benchRuns = runs;
+        } else if (arg == "--stats") {
+            dflags.stats = true;
+        } else if (arg.find("--trace=") == 0) {
+            dflags.traceFile = arg.substr(8);
+        } else if (arg == "--external-tools") {
+            flags.externalTools = true;
+        } else if (arg == "-O0" || arg == "-O1" || arg == "-O2" || arg == "-O3") {
+            flags.optLevel = arg[2] - '0';
+            flags.optSize = false;
+        } else if (arg == "-Os") {
+            flags.optLevel = 2;
+            flags.optSize = true;
+        } else if (arg.find("-march=") == 0) {
+            flags.cpu = arg.substr(7);
+        } else if (arg.find("-mcpu=") == 0) {
+            flags.cpu = arg.substr(6);
+        } else if (arg.find("-mattr=") == 0) {
+            flags.features = arg.substr(7);
+        } else if (arg == "-o") {
+            if (!hasValue(args, i)) return 1;
+            flags.name = args[i+1];
+            dflags.hasOutput = true;
+            i += 1;
+        } else if (arg[0] == '-') {
+            std::cerr << "Invalid option: " << arg << std::endl;
+            return 1;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    
+    if (inputs.size() == 0) {
+        std::cerr << "Error: No input file specified." << std::endl;
+        return 1;
+    }
+    
+    // --bench times the frontend instead of compiling anything
+    if (dflags.bench != "") {
+        if (dflags.bench != "lex" && dflags.bench != "parse") {
+            std::cerr << "Error: --bench takes lex or parse." << std::endl;
+            return 1;
+        }
+        if (dflags.benchRuns < 1) {
+            std::cerr << "Error: --bench-runs must be at least 1." << std::endl;
+            return 1;
+        }
+        
+        for (std::string input : inputs) {
+            if (!runBenchmark(input, dflags.bench == "parse", dflags.benchRuns)) return 1;
+        }
+        return 0;
+    }
+    
+    // --emit-module precompiles headers instead of compiling anything
+    if (dflags.emitModule) {
+        if (dflags.hasOutput && inputs.size() > 1) {
+            std::cerr << "Error: Cannot use -o with --emit-module and multiple headers." << std::endl;
+            return 1;
+        }
+        
+        for (std::string input : inputs) {
+            std::shared_ptr<Header> header = getHeader(input);
+            if (!header) return 1;
+            
+            std::string output = getModulePath(input);
+            if (dflags.hasOutput) output = flags.name;
+            if (!writeModule(header.get(), output)) return 1;
+        }
+        return 0;
+    }
+    
+    if (dflags.run && inputs.size() > 1) {
+        std::cerr << "Error: --run takes a single input file." << std::endl;
+        return 1;
+    }
+    if (dflags.run) dflags.runArgs.insert(dflags.runArgs.begin(), inputs[0]);
+    
+    if (dflags.compileOnly && dflags.depFile != "" && inputs.size() > 1) {
+        std::cerr << "Error: Cannot use -MF with -c and multiple input files." << std::endl;
+        return 1;
+    }
+    
+    if (dflags.compileOnly && dflags.hasOutput && inputs.size() > 1) {
+        std::cerr << "Error: Cannot use -o with -c and multiple input files." << std::endl;
+        return 1;
+    }
+    
+    initTiming(dflags.timeReport, dflags.traceFile != "", dflags.stats);
+    Compiler::resetPassTimes();
+    if (dflags.stats) llvm::EnableStatistics(false);
+    
+    // Resolve -march=native once, rather than in every unit
+    Compiler::resolveTargetCPU(flags);
+    
+    // Only a full build ends with a link
+    bool noOutput = dflags.testLex || dflags.printAst || dflags.emitDot || dflags.printLLVM || dflags.emitLLVM || dflags.run;
+    
+    // Compile the units on a pool of worker threads. Each unit gets its own parser
+    // and compiler (and so its own LLVM context). Anything that prints the
+    // intermediate stages (or the stats) runs on one thread so the output stays readable
+    int jobs = dflags.jobs;
+    if (jobs <= 0) jobs = std::thread::hardware_concurrency();
+    if (noOutput || dflags.emitPreproc || dflags.stats) jobs = 1;
+    if (jobs > (int)inputs.size()) jobs = inputs.size();
+    
+    // Objects for the link (and the assembly, with --external-tools) are temporary
+    if (!noOutput && (!dflags.compileOnly || flags.externalTools)) {
+        if (!makeTempDir(dflags)) return 1;
+    }
+    
+    std::vector<std::string> objects(inputs.size());
+    std::vector<std::vector<std::string>> deps(inputs.size());
+    std::vector<int> codes(inputs.size(), 0);
+    std::atomic<size_t> next(0);
+    
+    auto worker = [&]() {
+        for (size_t i = next++; i < inputs.size(); i = next++) {
+            codes[i] = compileUnit(inputs[i], i, objects[i], deps[i], flags, dflags);
+        }
+    };
+    
+    if (jobs <= 1) {
+        worker();
+    } else {
+        std::vector<std::thread> pool;
+        for (int i = 0; i<jobs; i++) {
+            pool.push_back(std::thread([&]() {
+                startTimingThread();
+                worker();
+                finishTimingThread();
+            }));
+        }
+        for (auto &t : pool) t.join();
+    }
+    
+    // Sort out what we have to link
+    bool failed = false;
+    std::vector<std::string> toLink;
+    
+    for (size_t i = 0; i<inputs.size(); i++) {
+        if (codes[i] != 0) failed = true;
+        if (objects[i] != "") toLink.push_back(objects[i]);
+    }
+    
+    bool linked = true;
+    if (!failed && !dflags.compileOnly && !noOutput) {
+        PhaseTimer timer("Link", flags.name);
+        linked = Compiler::link(toLink, flags);
+    }
+    
+    // Nothing else uses the temporary directory, so it all goes, along with
+    // the assembly from --external-tools
+    if (dflags.tempDir != "") sys::fs::remove_directories(dflags.tempDir);
+    
+    // With -c each object gets its own depfile; otherwise the program gets one
+    // that covers every unit (and any objects given to the link)
+    if (dflags.writeDeps && !failed && linked && !noOutput) {
+        if (dflags.compileOnly) {
+            for (size_t i = 0; i<inputs.size(); i++) {
+                if (deps[i].size() == 0) continue;
+                
+                std::string depFile = dflags.depFile;
+                if (depFile == "") depFile = getDepfilePath(objects[i]);
+                if (!writeDepfile(depFile, objects[i], deps[i])) return 1;
+            }
+        } else {
+            std::vector<std::string> allDeps;
+            for (size_t i = 0; i<inputs.size(); i++) {
+                if (deps[i].size() == 0) deps[i].push_back(inputs[i]);
+                for (std::string dep : deps[i]) {
+                    if (std::find(allDeps.begin(), allDeps.end(), dep) == allDeps.end()) allDeps.push_back(dep);
+                }
+            }
+            
+            std::string depFile = dflags.depFile;
+            if (depFile == "") depFile = getDepfilePath(flags.name);
+            if (!writeDepfile(depFile, flags.name, allDeps)) return 1;
+        }
+    }
+    
+    if (flags.timePasses) Compiler::printPassTimes();
+    printTimeReport();
+    if (dflags.stats) {
+        printMemoryReport();
+        llvm::PrintStatistics(llvm::errs());
+        llvm::ResetStatistics();
+    }
+    if (dflags.traceFile != "" && !writeTrace(dflags.traceFile)) return 1;
+    
+    if (failed || !linked) return 1;
+    if (dflags.run) return dflags.runResult;
+    return 0;
+}
@@ -0,0 +1,13 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Runs a full compile for the given command line (without the program name)
+// Returns the exit code for the process
+int runDriver(std::vector<std::string> args);
@@ -0,0 +1,190 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <mutex>
+#include <ctime>
+#include <sys/resource.h>
+
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <driver/Timing.hpp>
+
+using namespace llvm;
+
+struct PhaseTotal {
+    std::string phase;
+    double wall = 0;
+    double cpu = 0;
+    int count = 0;
+    long peakRSS = 0;       // In KB; the process' high water mark, not the phase's own
+    bool nested = false;    // Ran inside another phase, which counts its time too
+};
+
+static bool reportEnabled = false;
+static bool traceEnabled = false;
+static bool memoryEnabled = false;
+static std::mutex totalsLock;
+static std::vector<PhaseTotal> totals;      // In the order phases first started
+static std::chrono::steady_clock::time_point wallStart;
+static double cpuStart = 0;
+
+// How many phases are open on this thread
+static thread_local int depth = 0;
+
+// CPU time of the calling thread, in seconds
+static double getThreadCPUTime() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// CPU time of every thread in the process, in seconds
+static double getProcessCPUTime() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// The high water mark of the process, in KB
+static long getPeakRSS() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+void initTiming(bool report, bool trace, bool memory) {
+    reportEnabled = report;
+    memoryEnabled = memory;
+    totals.clear();
+    wallStart = std::chrono::steady_clock::now();
+    cpuStart = getProcessCPUTime();
+    
+    // LLVM's own pass timers are left off. The legacy code generation passes
+    // would print a report per unit, from whichever thread finishes it; their
+    // time is in the Emit phase instead.
+    
+    if (traceEnabled) timeTraceProfilerCleanup();
+    traceEnabled = trace;
+    if (trace) timeTraceProfilerInitialize(0, "tlc");
+}
+
+void startTimingThread() {
+    if (traceEnabled) timeTraceProfilerInitialize(0, "tlc");
+}
+
+void finishTimingThread() {
+    if (traceEnabled) timeTraceProfilerFinishThread();
+}
+
+void printTimeReport() {
+    if (!reportEnabled) return;
+    
+    // The phases overlap when they nest or run on several threads, so adding
+    // them up would overstate the total; it is measured on its own instead
+    std::chrono::duration<double> totalWall = std::chrono::steady_clock::now() - wallStart;
+    double totalCPU = getProcessCPUTime() - cpuStart;
+    
+    std::cerr << "===-------------------------------------------------------------------------===" << std::endl;
+    std::cerr << "                          tlc phase timing report" << std::endl;
+    std::cerr << "===-------------------------------------------------------------------------===" << std::endl;
+    std::cerr << std::left << std::setw(16) << "  Phase" << std::right
+        << std::setw(14) << "Wall (s)" << std::setw(14) << "CPU (s)" << std::setw(10) << "Count" << std::endl;
+    
+    std::cerr << std::fixed << std::setprecision(4);
+    for (auto &t : totals) {
+        std::string name = t.nested ? "  " + t.phase : t.phase;
+        std::cerr << "  " << std::left << std::setw(14) << name << std::right
+            << std::setw(14) << t.wall << std::setw(14) << t.cpu << std::setw(10) << t.count << std::endl;
+    }
+    std::cerr << "  " << std::left << std::setw(14) << "Total" << std::right
+        << std::setw(14) << totalWall.count() << std::setw(14) << totalCPU << std::endl;
+    std::cerr << std::defaultfloat;
+    std::cerr << "Indented phases are also counted in the phase that runs them. Phase times" << std::endl;
+    std::cerr << "are summed over units and threads; the total is the run's own wall and CPU time." << std::endl;
+}
+
+void printMemoryReport() {
+    if (!memoryEnabled) return;
+    
+    // ru_maxrss never goes down, so this is the process' peak so far when each
+    // phase last finished, not what the phase itself used
+    std::cerr << "Peak RSS of the process so far, at the end of each phase:" << std::endl;
+    for (auto &t : totals) {
+        std::string name = t.nested ? "  " + t.phase : t.phase;
+        std::cerr << "  " << std::left << std::setw(14) << name << std::right
+            << std::setw(12) << t.peakRSS << " KB" << std::endl;
+    }
+    std::cerr << "  " << std::left << std::setw(14) << "Process" << std::right
+        << std::setw(12) << getPeakRSS() << " KB" << std::endl;
+}
+
+bool writeTrace(std::string path) {
+    if (!traceEnabled) return true;
+    
+    std::error_code errorCode;
+    raw_fd_ostream writer(path, errorCode, sys::fs::OF_None);
+    if (errorCode) {
+        std::cerr << "Error: Unable to open trace file: " << path << std::endl;
+        return false;
+    }
+    
+    timeTraceProfilerWrite(writer);
+    timeTraceProfilerCleanup();
+    traceEnabled = false;
+    return true;
+}
+
+PhaseTimer::PhaseTimer(std::string phase, std::string detail) {
+    if (!reportEnabled && !traceEnabled && !memoryEnabled) return;
+    
+    this->phase = phase;
+    active = true;
+    wallStart = std::chrono::steady_clock::now();
+    cpuStart = getThreadCPUTime();
+    
+    // Listed in the order they start, so a nested phase comes after its parent
+    if (reportEnabled || memoryEnabled) {
+        std::lock_guard<std::mutex> lock(totalsLock);
+        bool found = false;
+        for (auto &t : totals) {
+            if (t.phase == phase) found = true;
+        }
+        if (!found) {
+            PhaseTotal t;
+            t.phase = phase;
+            t.nested = depth > 0;
+            totals.push_back(t);
+        }
+    }
+    ++depth;
+    
+    if (traceEnabled) timeTraceProfilerBegin(phase, detail);
+}
+
+PhaseTimer::~PhaseTimer() {
+    if (!active) return;
+    --depth;
+    if (traceEnabled) timeTraceProfilerEnd();
+    if (!reportEnabled && !memoryEnabled) return;
+    
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wallStart;
+    double cpu = getThreadCPUTime() - cpuStart;
+    long rss = memoryEnabled ? getPeakRSS() : 0;
+    
+    std::lock_guard<std::mutex> lock(totalsLock);
+    for (auto &t : totals) {
+        if (t.phase != phase) continue;
+        t.wall += wall.count();
+        t.cpu += cpu;
+        ++t.count;
+        if (rss > t.peakRSS) t.peakRSS = rss;
+        return;
+    }
+}
@@ -0,0 +1,44 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#pragma once
+
+#include <string>
+#include <chrono>
+
+//
+// Per-phase timing for -ftime-report and --trace
+// Phases are timed with a PhaseTimer on the stack. The report adds up each phase
+// over all units (and threads); the trace keeps every span, along with whatever
+// LLVM records, in Chrome's trace_event format. With --stats, the peak RSS of
+// the process so far is sampled at the end of each phase as well.
+//
+
+// Resets all timing state, and turns the report, trace and/or memory stats on
+void initTiming(bool report, bool trace, bool memory = false);
+
+// Worker threads have their own trace buffers, which have to be set up and handed back
+void startTimingThread();
+void finishTimingThread();
+
+// Prints the report to stderr
+void printTimeReport();
+
+// Prints the process' peak RSS so far after each phase to stderr
+void printMemoryReport();
+
+// Writes the Chrome trace file
+bool writeTrace(std::string path);
+
+class PhaseTimer {
+public:
+    explicit PhaseTimer(std::string phase, std::string detail = "");
+    ~PhaseTimer();
+private:
+    std::string phase;
+    bool active = false;
+    std::chrono::steady_clock::time_point wallStart;
+    double cpuStart = 0;
+};
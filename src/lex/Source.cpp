@@ -0,0 +1,51 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <lex/Source.hpp>
+
+Source::Source(std::string name, std::string content) {
+    this->name = name;
+    this->content = std::move(content);
+    data = this->content.data();
+    size = this->content.length();
+}
+
+Source::~Source() {
+    if (mapping) munmap(mapping, size);
+}
+
+std::unique_ptr<Source> Source::open(std::string path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) return nullptr;
+    
+    struct stat info;
+    if (fstat(fd, &info) == -1 || !S_ISREG(info.st_mode)) {
+        close(fd);
+        return nullptr;
+    }
+    
+    std::unique_ptr<Source> source(new Source(path));
+    
+    // mmap can't map an empty file, but then there is nothing to read anyway
+    if (info.st_size > 0) {
+        void *mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            close(fd);
+            return nullptr;
+        }
+        
+        source->mapping = mapping;
+        source->data = (const char *)mapping;
+        source->size = info.st_size;
+    }
+    
+    close(fd);
+    return source;
+}
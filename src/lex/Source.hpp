@@ -0,0 +1,36 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#pragma once
+
+#include <string>
+#include <memory>
+#include <cstddef>
+
+//
+// A source buffer for the scanner
+// Files are memory-mapped and read in place; the preprocessor hands its output
+// over as a string. Either way, nothing goes through a temporary file.
+//
+class Source {
+public:
+    explicit Source(std::string name, std::string content);
+    ~Source();
+    
+    // Maps a file; returns nullptr if it can't be opened
+    static std::unique_ptr<Source> open(std::string path);
+    
+    std::string getName() { return name; }
+    const char *getData() { return data; }
+    size_t getSize() { return size; }
+private:
+    explicit Source(std::string name) { this->name = name; }
+    
+    std::string name = "";
+    std::string content = "";
+    const char *data = nullptr;
+    size_t size = 0;
+    void *mapping = nullptr;
+};
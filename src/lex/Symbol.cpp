@@ -0,0 +1,106 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#include <unordered_map>
+#include <mutex>
+#include <stdexcept>
+
+#include <lex/Symbol.hpp>
+
+//
+// The strings are kept in chunks that never move, so str() can hand out a
+// reference without taking the lock, and the map can key on views of them.
+// A symbol only gets to another thread through something that is already
+// synchronized (the table's lock, or the header cache), so the chunk it is in
+// is always visible by then.
+//
+// Each chunk is twice the size of the one before, so a small directory covers
+// every 32-bit ID, and the table grows for as long as there is memory.
+//
+namespace {
+
+const uint32_t FIRST_BITS = 12;
+const uint64_t FIRST_SIZE = 1 << FIRST_BITS;
+const uint32_t MAX_CHUNKS = 33 - FIRST_BITS;
+
+// Finds the chunk an ID is in, and its place there
+inline uint32_t getChunk(uint32_t id, uint64_t &index) {
+    uint64_t n = id + FIRST_SIZE;
+    uint32_t chunk = (63 - __builtin_clzll(n)) - FIRST_BITS;
+    index = n - (FIRST_SIZE << chunk);
+    return chunk;
+}
+
+struct SymbolTable {
+    SymbolTable() {
+        init();
+    }
+
+    void init() {
+        chunks[0] = new std::string[FIRST_SIZE];
+        ids[std::string_view(chunks[0][0])] = 0;
+        count = 1;
+    }
+
+    std::mutex lock;
+    std::unordered_map<std::string_view, uint32_t> ids;
+    std::string *chunks[MAX_CHUNKS] = { nullptr };
+    uint64_t count = 0;
+};
+
+SymbolTable &getTable() {
+    static SymbolTable *table = new SymbolTable;
+    return *table;
+}
+
+}
+
+uint32_t Symbol::intern(std::string_view text) {
+    if (text.empty()) return 0;
+
+    SymbolTable &table = getTable();
+    std::lock_guard<std::mutex> guard(table.lock);
+
+    auto entry = table.ids.find(text);
+    if (entry != table.ids.end()) return entry->second;
+
+    // IDs are 32 bits, and that is the only limit
+    if (table.count > UINT32_MAX) throw std::length_error("Too many symbols");
+
+    uint32_t id = table.count;
+    uint64_t index = 0;
+    uint32_t chunk = getChunk(id, index);
+    if (!table.chunks[chunk]) table.chunks[chunk] = new std::string[FIRST_SIZE << chunk];
+
+    std::string &str = table.chunks[chunk][index];
+    str = text;
+    table.ids[std::string_view(str)] = id;
+    ++table.count;
+    return id;
+}
+
+const std::string &Symbol::str() const {
+    uint64_t index = 0;
+    uint32_t chunk = getChunk(id, index);
+    return getTable().chunks[chunk][index];
+}
+
+size_t Symbol::getCount() {
+    SymbolTable &table = getTable();
+    std::lock_guard<std::mutex> guard(table.lock);
+    return table.count;
+}
+
+void Symbol::reset() {
+    SymbolTable &table = getTable();
+    std::lock_guard<std::mutex> guard(table.lock);
+
+    table.ids.clear();
+    for (uint32_t i = 0; i<MAX_CHUNKS; i++) {
+        delete[] table.chunks[i];
+        table.chunks[i] = nullptr;
+    }
+    table.init();
+}
@@ -0,0 +1,59 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <functional>
+#include <cstdint>
+
+//
+// An interned identifier or string literal
+// The scanner interns every name it reads, so the rest of the front end only
+// passes around a 32-bit ID; comparing or hashing a symbol never touches the
+// text. The text lives in a process-wide table, since header ASTs (and the
+// symbols in them) are shared between threads and builds. Nothing is freed
+// until the table is reset, which the compile server does between jobs once
+// it has grown large.
+//
+// ID 0 is always the empty string.
+//
+class Symbol {
+public:
+    Symbol() {}
+    explicit Symbol(std::string_view text) : id(intern(text)) {}
+
+    uint32_t getId() const { return id; }
+    bool empty() const { return id == 0; }
+
+    // The text; the reference stays valid until the table is reset
+    const std::string &str() const;
+
+    bool operator==(Symbol other) const { return id == other.id; }
+    bool operator!=(Symbol other) const { return id != other.id; }
+    bool operator<(Symbol other) const { return id < other.id; }
+    // The number of symbols in the table, counting the empty string
+    static size_t getCount();
+
+    // Drops every symbol but the empty string. Nothing may hold on to a symbol
+    // (or be running) when this is called.
+    static void reset();
+private:
+    static uint32_t intern(std::string_view text);
+
+    uint32_t id = 0;
+};
+
+inline std::ostream &operator<<(std::ostream &out, Symbol symbol) {
+    return out << symbol.str();
+}
+
+namespace std {
+    template<> struct hash<Symbol> {
+        size_t operator()(Symbol symbol) const { return symbol.getId(); }
+    };
+}
@@ -0,0 +1,504 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#include <iostream>
+#include <cctype>
+#include <cstring>
+#include <cstdint>
+#include <cassert>
+#include <charconv>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <lex/lex.hpp>
+
+//
+// The scanning loops
+// Each of these finds the end of a run of one kind of character. With SSE2 (which
+// every x86-64 target has) they check 16 bytes at a time, and only go a byte at a
+// time at the end of the buffer or on other targets.
+//
+namespace {
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool isSymbol(char c) {
+    return c != 0 && strchr(".;,()[]+-*/%&|^:><=!", c) != nullptr;
+}
+
+bool isIdChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Anything that doesn't end a word is part of it
+bool isWordChar(char c) {
+    return !isSpace(c) && !isSymbol(c) && c != '#' && c != '\"' && c != '\'';
+}
+
+// Skips whitespace, adding any newlines to lineNo
+const char *skipSpace(const char *pos, const char *end, int &lineNo) {
+    if (pos < end && !isSpace(*pos)) return pos;
+    
+#ifdef __SSE2__
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i nl = _mm_set1_epi8('\n');
+    
+    while (end - pos >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)pos);
+        __m128i newlines = _mm_cmpeq_epi8(chunk, nl);
+        __m128i spaces = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+                                      _mm_or_si128(_mm_cmpeq_epi8(chunk, cr), newlines));
+        
+        unsigned mask = _mm_movemask_epi8(spaces);
+        unsigned lines = _mm_movemask_epi8(newlines);
+        if (mask != 0xFFFF) {
+            unsigned run = __builtin_ctz(~mask);
+            lineNo += __builtin_popcount(lines & ((1u << run) - 1));
+            return pos + run;
+        }
+        
+        lineNo += __builtin_popcount(lines);
+        pos += 16;
+    }
+#endif
+    
+    while (pos < end && isSpace(*pos)) {
+        if (*pos == '\n') ++lineNo;
+        ++pos;
+    }
+    return pos;
+}
+
+// Finds the end of a run of [A-Za-z0-9_]
+const char *scanId(const char *pos, const char *end) {
+#ifdef __SSE2__
+    // The compares are signed, so anything past ASCII fails both range checks
+    const __m128i lowerA = _mm_set1_epi8('a' - 1);
+    const __m128i lowerZ = _mm_set1_epi8('z' + 1);
+    const __m128i digit0 = _mm_set1_epi8('0' - 1);
+    const __m128i digit9 = _mm_set1_epi8('9' + 1);
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i underscore = _mm_set1_epi8('_');
+    
+    while (end - pos >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)pos);
+        __m128i lower = _mm_or_si128(chunk, caseBit);
+        
+        __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, lowerA), _mm_cmplt_epi8(lower, lowerZ));
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(chunk, digit0), _mm_cmplt_epi8(chunk, digit9));
+        __m128i id = _mm_or_si128(_mm_or_si128(alpha, digit), _mm_cmpeq_epi8(chunk, underscore));
+        
+        unsigned mask = _mm_movemask_epi8(id);
+        if (mask != 0xFFFF) return pos + __builtin_ctz(~mask);
+        pos += 16;
+    }
+#endif
+    
+    while (pos < end && isIdChar(*pos)) ++pos;
+    return pos;
+}
+
+// Words are almost always identifiers; anything else in one is stepped over a byte at a time
+const char *scanWord(const char *pos, const char *end) {
+    for (;;) {
+        pos = scanId(pos, end);
+        if (pos >= end || !isWordChar(*pos)) return pos;
+        ++pos;
+    }
+}
+
+// Finds the closing quote, or the next escape
+const char *scanString(const char *pos, const char *end, char quote) {
+#ifdef __SSE2__
+    const __m128i quoteChar = _mm_set1_epi8(quote);
+    const __m128i escape = _mm_set1_epi8('\\');
+    
+    while (end - pos >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)pos);
+        __m128i stop = _mm_or_si128(_mm_cmpeq_epi8(chunk, quoteChar), _mm_cmpeq_epi8(chunk, escape));
+        
+        unsigned mask = _mm_movemask_epi8(stop);
+        if (mask != 0) return pos + __builtin_ctz(mask);
+        pos += 16;
+    }
+#endif
+    
+    while (pos < end && *pos != quote && *pos != '\\') ++pos;
+    return pos;
+}
+
+//
+// The keywords
+// These are found with a perfect hash: the multipliers are picked so that no two
+// keywords land in the same slot, which is checked when this file is compiled.
+// A word then only needs one compare to tell if it is a keyword.
+//
+struct Keyword {
+    std::string_view text;
+    TokenType type;
+};
+
+constexpr Keyword keywords[] = {
+    {"extern", Extern}, {"func", Func}, {"struct", Struct}, {"end", End}, {"return", Return},
+    {"var", VarD}, {"const", Const}, {"bool", Bool}, {"char", Char}, {"string", Str},
+    {"i8", I8}, {"u8", U8}, {"i16", I16}, {"u16", U16}, {"i32", I32}, {"u32", U32},
+    {"i64", I64}, {"u64", U64}, {"if", If}, {"elif", Elif}, {"else", Else}, {"while", While},
+    {"is", Is}, {"then", Then}, {"do", Do}, {"break", Break}, {"continue", Continue},
+    {"import", Import}, {"true", True}, {"false", False}, {"and", Logical_And}, {"or", Logical_Or}
+};
+
+const unsigned KEYWORD_SLOTS = 128;
+
+constexpr unsigned hashKeyword(std::string_view word) {
+    return (word.length() + (unsigned char)word.front() * 3 + (unsigned char)word.back() * 36) & (KEYWORD_SLOTS - 1);
+}
+
+struct KeywordTable {
+    int slots[KEYWORD_SLOTS];
+    size_t minLength;
+    size_t maxLength;
+    bool perfect;
+};
+
+constexpr KeywordTable buildKeywordTable() {
+    KeywordTable table {};
+    table.minLength = keywords[0].text.length();
+    table.maxLength = keywords[0].text.length();
+    table.perfect = true;
+    
+    for (unsigned i = 0; i<KEYWORD_SLOTS; i++) table.slots[i] = -1;
+    
+    for (int i = 0; i<(int)(sizeof(keywords) / sizeof(keywords[0])); i++) {
+        std::string_view text = keywords[i].text;
+        if (text.length() < table.minLength) table.minLength = text.length();
+        if (text.length() > table.maxLength) table.maxLength = text.length();
+        
+        unsigned slot = hashKeyword(text);
+        if (table.slots[slot] != -1) table.perfect = false;
+        table.slots[slot] = i;
+    }
+    
+    return table;
+}
+
+constexpr KeywordTable keywordTable = buildKeywordTable();
+static_assert(keywordTable.perfect, "Two keywords hash to the same slot; the multipliers in hashKeyword need changing");
+
+}
+
+// Maps and scans a file
+Scanner::Scanner(std::string input) {
+    ownedSource = Source::open(input);
+    if (!ownedSource) {
+        std::cout << "Unknown input file." << std::endl;
+        error = true;
+        return;
+    }
+    
+    file = input;
+    start = ownedSource->getData();
+    pos = start;
+    end = start + ownedSource->getSize();
+    rawStart = start;
+}
+
+// Scans a buffer owned by someone else
+Scanner::Scanner(Source *source) {
+    file = source->getName();
+    start = source->getData();
+    pos = start;
+    end = start + source->getSize();
+    rawStart = start;
+}
+
+Scanner::~Scanner() {}
+
+// TODO: We need better path support
+std::string Scanner::getImportPath(std::string name) {
+    return "/usr/local/include/tinylang/" + name + ".th";
+}
+
+// Reads the rest of an import line, and passes the header on
+bool Scanner::readImport() {
+    std::string name = "";
+    Token token = lex();
+    while (token.type != SemiColon && token.type != Eof) {
+        switch (token.type) {
+            case Id: name += token.id_val.str(); break;
+            case Dot: name += "/"; break;
+            
+            default: {
+                std::cerr << "[" << lineNo << "] Invalid token in import." << std::endl;
+                return false;
+            }
+        }
+        
+        token = lex();
+    }
+    
+    return importHandler(getImportPath(name));
+}
+
+// The keys are views of the interned text, so a hit costs one hash and no lock
+Symbol Scanner::intern(std::string_view text) {
+    auto entry = symbols.find(text);
+    if (entry != symbols.end()) return entry->second;
+    
+    Symbol symbol(text);
+    symbols[std::string_view(symbol.str())] = symbol;
+    return symbol;
+}
+
+// Lexes up to the token k ahead. k has to be less than LOOKAHEAD.
+const Token &Scanner::peek(int k) {
+    assert(k >= 0 && k < LOOKAHEAD && "peek() past the end of the lookahead ring");
+    while (count <= k) {
+        Token &token = lookahead[(head + count) & (LOOKAHEAD - 1)];
+        token = lex();
+        token.line = lineNo;
+        ++count;
+    }
+    return lookahead[(head + k) & (LOOKAHEAD - 1)];
+}
+
+void Scanner::consume(int n) {
+    assert(n >= 1 && n <= LOOKAHEAD && "consume() past the end of the lookahead ring");
+    line = peek(n - 1).line;
+    head = (head + n) & (LOOKAHEAD - 1);
+    count -= n;
+}
+
+Token Scanner::getNext() {
+    Token token = peek();
+    consume();
+    return token;
+}
+
+// Returns everything read since the last call
+std::string Scanner::getRawBuffer() {
+    std::string ret(rawStart, pos - rawStart);
+    rawStart = pos;
+    return ret;
+}
+
+// Reads the next token from the buffer
+Token Scanner::lex() {
+    Token token;
+    
+    // A failed import ends the file
+    if (error) {
+        token.type = Eof;
+        return token;
+    }
+    
+    for (;;) {
+        pos = skipSpace(pos, end, lineNo);
+        if (pos >= end) {
+            token.type = Eof;
+            return token;
+        }
+        
+        // Comments run to the end of the line; the newline is counted on the next pass
+        if (*pos != '#') break;
+        const char *newline = (const char *)memchr(pos, '\n', end - pos);
+        pos = newline ? newline : end;
+    }
+    
+    char next = *pos;
+    
+    // String and character literals
+    if (next == '\"' || next == '\'') {
+        ++pos;
+        return readString(next);
+    }
+    
+    if (isSymbol(next)) {
+        ++pos;
+        token.type = getSymbol(next);
+        return token;
+    }
+    
+    // Anything else is a word, which is read straight out of the buffer
+    const char *wordStart = pos;
+    pos = scanWord(pos, end);
+    std::string_view word(wordStart, pos - wordStart);
+    
+    token.type = getKeyword(word);
+    if (token.type == Import && importHandler) {
+        if (!readImport()) {
+            error = true;
+            token.type = Eof;
+            return token;
+        }
+        return lex();
+    }
+    
+    if (token.type != EmptyToken) {
+        return token;
+    }
+    
+    // A literal that doesn't fit is reported, but still comes through as a
+    // number so the parser can carry on
+    if (isInt(word)) {
+        token.type = Int32;
+        int32_t value = 0;
+        if (std::from_chars(word.data(), word.data() + word.length(), value).ec != std::errc()) {
+            reportError("Integer literal out of range: " + std::string(word));
+        }
+        token.i32_val = value;
+    } else if (isHex(word)) {
+        // Hex literals are bit patterns, so they can use all 32 bits
+        token.type = Int32;
+        uint32_t value = 0;
+        if (std::from_chars(word.data() + 2, word.data() + word.length(), value, 16).ec != std::errc()) {
+            reportError("Integer literal out of range: " + std::string(word));
+        }
+        token.i32_val = value;
+    } else {
+        token.type = Id;
+        token.id_val = intern(word);
+    }
+    
+    return token;
+}
+
+void Scanner::reportError(std::string message) {
+    if (errorHandler) errorHandler(lineNo, message);
+    else std::cerr << "[" << lineNo << "] Syntax Error: " << message << std::endl;
+}
+
+// Reads a literal after the opening quote. Most have no escapes, and those are
+// interned straight from the buffer; the rest are copied out a run at a time.
+Token Scanner::readString(char quote) {
+    const char *literalStart = pos;
+    pos = scanString(pos, end, quote);
+    std::string_view text(literalStart, pos - literalStart);
+    
+    std::string value = "";
+    if (pos < end && *pos == '\\') {
+        value.assign(text);
+        
+        while (pos < end && *pos == '\\') {
+            ++pos;
+            if (pos >= end) {
+                value += '\\';
+                break;
+            }
+            
+            char c = *pos++;
+            switch (c) {
+                case 'n': value += '\n'; break;
+                case 't': value += '\t'; break;
+                default: value += c;
+            }
+            
+            const char *runStart = pos;
+            pos = scanString(pos, end, quote);
+            value.append(runStart, pos - runStart);
+        }
+        
+        text = value;
+    }
+    
+    // The closing quote
+    if (pos < end) ++pos;
+    
+    Token token;
+    if (quote == '\"') {
+        token.type = String;
+        token.id_val = intern(text);
+    } else {
+        token.type = CharL;
+        token.i8_val = text.empty() ? 0 : text[0];
+    }
+    return token;
+}
+
+TokenType Scanner::getKeyword(std::string_view word) {
+    if (word.length() < keywordTable.minLength || word.length() > keywordTable.maxLength) {
+        return EmptyToken;
+    }
+    
+    int slot = keywordTable.slots[hashKeyword(word)];
+    if (slot == -1 || keywords[slot].text != word) return EmptyToken;
+    return keywords[slot].type;
+}
+
+// Two-character symbols are checked with a look at the next character
+TokenType Scanner::getSymbol(char c) {
+    char peek = (pos < end) ? *pos : 0;
+    
+    switch (c) {
+        case '.': return Dot;
+        case ';': return SemiColon;
+        case ',': return Comma;
+        case '(': return LParen;
+        case ')': return RParen;
+        case '[': return LBracket;
+        case ']': return RBracket;
+        case '+': return Plus;
+        case '*': return Mul;
+        case '/': return Div;
+        case '%': return Mod;
+        case '&': return And;
+        case '|': return Or;
+        case '^': return Xor;
+        case '=': return EQ;
+        
+        case '-': {
+            if (peek != '>') return Minus;
+            ++pos;
+            return Arrow;
+        }
+        
+        case ':': {
+            if (peek != '=') return Colon;
+            ++pos;
+            return Assign;
+        }
+        
+        case '>': {
+            if (peek != '=') return GT;
+            ++pos;
+            return GTE;
+        }
+        
+        case '<': {
+            if (peek != '=') return LT;
+            ++pos;
+            return LTE;
+        }
+        
+        case '!': {
+            if (peek != '=') return EmptyToken;
+            ++pos;
+            return NEQ;
+        }
+        
+        default: {}
+    }
+    return EmptyToken;
+}
+
+bool Scanner::isInt(std::string_view word) {
+    for (char c : word) {
+        if (!isdigit((unsigned char)c)) return false;
+    }
+    return true;
+}
+
+bool Scanner::isHex(std::string_view word) {
+    if (word.length() < 3 || word[0] != '0' || word[1] != 'x') return false;
+    for (size_t i = 2; i<word.length(); i++) {
+        if (!isxdigit((unsigned char)word[i])) return false;
+    }
+    return true;
+}
@@ -0,0 +1,120 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#pragma once
+
+#include <string>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <string_view>
+
+#include <lex/Source.hpp>
+#include <lex/Symbol.hpp>
+
+// The tokens; see doc/lex.txt
+enum TokenType {
+    EmptyToken,
+    Eof,
+    Id,
+    String,
+    CharL,
+    Int32,
+    
+    // Keywords
+    Extern, Func, Struct, End, Return, VarD, Const, Bool, Char, Str,
+    I8, U8, I16, U16, I32, U32, I64, U64, If, Elif, Else, While, Is, Then, Do,
+    Break, Continue, Import, True, False, Logical_And, Logical_Or,
+    
+    // Symbols
+    Dot, SemiColon, Comma, LParen, RParen, LBracket, RBracket, Plus, Minus, Mul, Div, Mod,
+    And, Or, Xor, Colon, GT, GTE, LT, LTE, EQ, NEQ, Assign, Arrow
+};
+
+// Identifiers and string literals are interned, so a token is a few plain
+// values and copying one never allocates
+struct Token {
+    TokenType type = EmptyToken;
+    Symbol id_val;
+    char i8_val = 0;
+    int i32_val = 0;
+    int line = 0;       // The line the token is on
+    void print() const;
+};
+
+//
+// The scanner
+// This reads straight out of a Source buffer, which is either a mapped file or
+// something built in memory.
+//
+// With an import handler set, import lines are handled here: the scanner reads
+// the header path and hands it over, and the parser never sees the tokens. The
+// handler returns false if the import failed, which puts the scanner in an
+// error state. Without one, the import tokens are passed through.
+//
+// A literal that doesn't fit goes to the error handler (the parser adds it to
+// its own errors), and lexing carries on. Without one, it is printed.
+//
+class Scanner {
+public:
+    explicit Scanner(std::string input);
+    explicit Scanner(Source *source);
+    ~Scanner();
+    
+    void setImportHandler(std::function<bool(std::string)> handler) { importHandler = handler; }
+    void setErrorHandler(std::function<void(int, std::string)> handler) { errorHandler = handler; }
+    
+    // Lookahead; peek(k) is the token k past the next one, and nothing is
+    // lexed twice however many times it is looked at
+    const Token &peek(int k = 0);
+    void consume(int n = 1);
+    Token getNext();
+    std::string getRawBuffer();
+    
+    // The line of the last token consumed. The scanner itself may have read
+    // further ahead; use peek().line for the line of the next token.
+    int getLine() { return line; }
+    std::string getFile() { return file; }
+    bool isEof() { return pos >= end; }
+    bool isError() { return error; }
+    
+    // Turns "std/io" into the path to the header
+    static std::string getImportPath(std::string name);
+private:
+    Token lex();
+    bool readImport();
+    Symbol intern(std::string_view text);
+    void reportError(std::string message);
+    
+    std::unique_ptr<Source> ownedSource;
+    std::function<bool(std::string)> importHandler;
+    std::function<void(int, std::string)> errorHandler;
+    
+    // Names already seen in this file; saves a trip to the shared symbol table
+    std::unordered_map<std::string_view, Symbol> symbols;
+    
+    std::string file = "";
+    const char *start = nullptr;
+    const char *pos = nullptr;
+    const char *end = nullptr;
+    const char *rawStart = nullptr;     // Where the last getRawBuffer() left off
+    
+    bool error = false;
+    int lineNo = 1;     // Where lexing has got to
+    int line = 1;       // Where the parser has got to
+    
+    // The tokens read ahead, in a ring; head is the next one to be consumed
+    static const int LOOKAHEAD = 4;
+    static_assert((LOOKAHEAD & (LOOKAHEAD - 1)) == 0, "The ring is indexed with a mask, so LOOKAHEAD must be a power of two");
+    Token lookahead[LOOKAHEAD];
+    int head = 0;
+    int count = 0;
+    
+    Token readString(char quote);
+    TokenType getKeyword(std::string_view word);
+    TokenType getSymbol(char c);
+    bool isInt(std::string_view word);
+    bool isHex(std::string_view word);
+};
@@ -0,0 +1,12 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#include <iostream>
+
+#include <lex/lex.hpp>
+
+void Token::print() const {
+    std::cout << "TOKEN " << (int)type << " " << id_val << " " << i32_val << std::endl;
+}
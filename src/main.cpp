@@ -3,137 +3,22 @@
 // This file is part of the Tiny Lang compiler.
 // Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
 //
-#include <iostream>
 #include <string>
-#include <cstdio>
+#include <vector>
 
-#include <preproc/Preproc.hpp>
-#include <parser/Parser.hpp>
-#include <ast/ast.hpp>
-
-#include <compiler/Compiler.hpp>
-
-bool isError = false;
-
-// TODO: I'm not sure actually if the lex testing actually works
-//
-AstTree *getAstTree(std::string input, bool testLex, bool printAst, bool emitDot) {
-    Parser *frontend = new Parser(input);
-    AstTree *tree;
-    
-    if (testLex) {
-        frontend->debugScanner();
-        isError = false;
-        return nullptr;
-    }
-    
-    if (!frontend->parse()) {
-        delete frontend;
-        isError = true;
-        return nullptr;
-    }
-    
-    tree = frontend->getTree();
-    
-    delete frontend;
-    remove(input.c_str());
-    
-    if (printAst) {
-        tree->print();
-        return nullptr;
-    }
-    
-    if (emitDot) {
-        tree->dot();
-        return nullptr;
-    }
-    
-    return tree;
-}
-
-int compileLLVM(AstTree *tree, CFlags flags, bool printLLVM, bool emitLLVM) {
-    Compiler *compiler = new Compiler(tree, flags);
-    compiler->compile();
-        
-    if (printLLVM) {
-        compiler->debug();
-        return 0;
-    }
-    
-    if (emitLLVM) {
-        std::string output = flags.name;
-        if (output == "a.out") {
-            output = "./out.ll";
-        }
-            
-        compiler->emitLLVM(output);
-        return 0;
-    }
-        
-    compiler->writeAssembly();
-    compiler->assemble();
-    compiler->link();
-    
-    return 0;
-}
+#include <driver/Driver.hpp>
+#include <server/Server.hpp>
 
 int main(int argc, char **argv) {
-    if (argc == 1) {
-        std::cerr << "Error: No input file specified." << std::endl;
-        return 1;
-    }
+    std::vector<std::string> args;
+    for (int i = 1; i<argc; i++) args.push_back(argv[i]);
     
-    // Compiler (codegen) flags
-    CFlags flags;
-    flags.name = "a.out";
-    
-    // Other flags
-    std::string input = "";
-    bool emitPreproc = false;
-    bool testLex = false;
-    bool printAst = false;
-    bool emitDot = false;
-    bool printLLVM = false;
-    bool emitLLVM = false;
-    
-    for (int i = 1; i<argc; i++) {
-        std::string arg = argv[i];
-        
-        if (arg == "-E") {
-            emitPreproc = true;
-        } else if (arg == "--test-lex") {
-            testLex = true;
-        } else if (arg == "--ast") {
-            printAst = true;
-        } else if (arg == "--dot") {
-            emitDot = true;
-        } else if (arg == "--llvm") {
-            printLLVM = true;
-        } else if (arg == "--emit-llvm") {
-            emitLLVM = true;
-        } else if (arg == "-o") {
-            flags.name = argv[i+1];
-            i += 1;
-        } else if (arg[0] == '-') {
-            std::cerr << "Invalid option: " << arg << std::endl;
-            return 1;
-        } else {
-            input = arg;
-        }
-    }
-    
-    std::string newInput = preprocessFile(input, emitPreproc);
-    if (newInput == "") {
-        return 1;
+    // tlc --server[=<socket>] keeps the compiler resident and takes jobs from tlcc
+    if (args.size() > 0 && args[0].find("--server") == 0) {
+        std::string socketPath = getServerSocketPath();
+        if (args[0].find("--server=") == 0) socketPath = args[0].substr(9);
+        return runServer(socketPath);
     }
     
-    AstTree *tree = getAstTree(newInput, testLex, printAst, emitDot);
-    if (tree == nullptr) {
-        if (isError) return 1;
-        return 0;
-    }
-
-    // Compile
-    return compileLLVM(tree, flags, printLLVM, emitLLVM);
+    return runDriver(args);
 }
-
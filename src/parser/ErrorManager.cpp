@@ -32,14 +32,19 @@ bool ErrorManager::errorsPresent() {
 // Prints any errors
 void ErrorManager::printErrors() {
     for (Error err : errors) {
-        std::cout << "[" << err.line << "] Syntax Error: " << err.message << std::endl;
+        std::cout << "[" << getLocation(err.line) << "] Syntax Error: " << err.message << std::endl;
     }
 }
 
 // Prints any warnings
 void ErrorManager::printWarnings() {
     for (Error err : warnings) {
-        std::cout << "[" << err.line << "] Warning: " << err.message << std::endl;
+        std::cout << "[" << getLocation(err.line) << "] Warning: " << err.message << std::endl;
     }
 }
 
+
+std::string ErrorManager::getLocation(int line) {
+    if (file == "") return std::to_string(line);
+    return file + ":" + std::to_string(line);
+}
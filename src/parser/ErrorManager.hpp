@@ -15,12 +15,18 @@ struct Error {
 
 class ErrorManager {
 public:
+    // Errors in headers are printed with the header's name
+    void setFile(std::string file) { this->file = file; }
+    
     void addError(int line, std::string message);
     void addWarning(int line, std::string message);
     bool errorsPresent();
     void printErrors();
     void printWarnings();
 private:
+    std::string getLocation(int line);
+    
+    std::string file = "";
     std::vector<Error> errors;
     std::vector<Error> warnings;
 };
@@ -96,17 +96,18 @@ bool Parser::buildOperator(Token token, ExprContext *ctx) {
 
 bool Parser::buildIDExpr(Token token, ExprContext *ctx) {
     ctx->lastWasOp = false;
-    int currentLine = scanner->getLine();
 
-    std::string name = token.id_val;
+    Symbol name = token.id_val;
     if (ctx->varType && ctx->varType->getType() == V_AstType::Void) {
-        ctx->varType = typeMap[name];
+        ctx->varType = getVarType(name);
         if (ctx->varType && ctx->varType->getType() == V_AstType::Ptr)
             ctx->varType = static_cast<AstPointerType *>(ctx->varType)->getBaseType();
     }
     
-    token = scanner->getNext();
-    if (token.type == LBracket) {
+    TokenType next = scanner->peek().type;
+    if (next == LBracket) {
+        scanner->consume();
+        
         //AstExpression *index = nullptr;
         //buildExpression(nullptr, DataType::I32, RBracket, EmptyToken, &index);
         AstExpression *index = buildExpression(AstBuilder::buildInt32Type(), RBracket);
@@ -114,10 +115,11 @@ bool Parser::buildIDExpr(Token token, ExprContext *ctx) {
         AstArrayAccess *acc = new AstArrayAccess(name);
         acc->setIndex(index);
         ctx->output.push(acc);
-    } else if (token.type == LParen) {
-        if (currentLine != scanner->getLine()) {
-            syntax->addWarning(scanner->getLine(), "Function call on newline- possible logic error.");
+    } else if (next == LParen) {
+        if (token.line != scanner->peek().line) {
+            syntax->addWarning(scanner->peek().line, "Function call on newline- possible logic error.");
         }
+        scanner->consume();
         
         if (!isFunc(name)) {
             syntax->addError(scanner->getLine(), "Unknown function call.");
@@ -129,8 +131,20 @@ bool Parser::buildIDExpr(Token token, ExprContext *ctx) {
         fc->setArgExpression(args);
         
         ctx->output.push(fc);
-    } else if (token.type == Dot) {
-        // TODO: Search for structures here
+    } else if (next == Dot) {
+        scanner->consume();
+        
+        // The name has to be a structure variable, and the member one of its own
+        AstDataType *type = getVarType(name);
+        AstStruct *str = nullptr;
+        if (type && type->getType() == V_AstType::Struct) {
+            str = tree->getStruct(static_cast<AstStructType *>(type)->getName());
+        }
+        
+        if (!str) {
+            syntax->addError(scanner->getLine(), "Not a structure variable.");
+            return false;
+        }
 
         Token idToken = scanner->getNext();
         if (idToken.type != Id) {
@@ -138,6 +152,11 @@ bool Parser::buildIDExpr(Token token, ExprContext *ctx) {
             return false;
         }
         
+        if (!str->getMember(idToken.id_val)) {
+            syntax->addError(scanner->getLine(), "Unknown structure member.");
+            return false;
+        }
+        
         AstStructAccess *val = new AstStructAccess(name, idToken.id_val);
         ctx->output.push(val);
     } else {
@@ -147,7 +166,7 @@ bool Parser::buildIDExpr(Token token, ExprContext *ctx) {
                 AstExpression *expr = globalConsts[name].second;
                 ctx->output.push(expr);
             } else if (constVal == 2) {
-                AstExpression *expr = localConsts[name].second;
+                AstExpression *expr = locals.find(name)->value;
                 ctx->output.push(expr);
             }
         } else {
@@ -159,8 +178,6 @@ bool Parser::buildIDExpr(Token token, ExprContext *ctx) {
                 return false;
             }
         }
-        
-        scanner->rewind(token);
     }
     return true;
 }
@@ -15,7 +15,7 @@ AstExpression *Parser::checkCondExpression(AstExpression *toCheck) {
     switch (toCheck->getType()) {
         case V_AstType::ID: {
             AstID *id = static_cast<AstID *>(toCheck);
-            AstDataType *dataType = typeMap[id->getValue()];            
+            AstDataType *dataType = getVarType(id->getValue());
             AstEQOp *eq = new AstEQOp;
             eq->setLVal(id);
             
@@ -11,9 +11,10 @@
 
 // Returns the function arguments
 bool Parser::getFunctionArgs(std::vector<Var> &args) {
-    Token token = scanner->getNext();
-    if (token.type == LParen) {
-        token = scanner->getNext();
+    if (scanner->peek().type == LParen) {
+        scanner->consume();
+        
+        Token token = scanner->getNext();
         while (token.type != Eof && token.type != RParen) {
             Token t1 = token;
             Token t2 = scanner->getNext();
@@ -31,7 +32,6 @@ bool Parser::getFunctionArgs(std::vector<Var> &args) {
             
             v.type = buildDataType();
             v.name = t1.id_val;
-            vars.push_back(t1.id_val);
             
             token = scanner->getNext();
             if (token.type == Comma) {
@@ -39,10 +39,11 @@ bool Parser::getFunctionArgs(std::vector<Var> &args) {
             }
             
             args.push_back(v);
-            typeMap[v.name] = v.type;
+            
+            LocalName local;
+            local.type = v.type;
+            locals.declare(v.name, local);
         }
-    } else {
-        scanner->rewind(token);
     }
     
     return true;
@@ -50,9 +51,9 @@ bool Parser::getFunctionArgs(std::vector<Var> &args) {
 
 // Builds a function
 bool Parser::buildFunction(Token startToken, std::string className) {
-    typeMap.clear();
-    localConsts.clear();
-    vars.clear();
+    // The arguments are in the function's scope, and the body is nested in it
+    locals.clear();
+    locals.enterScope();
     
     Token token;
     bool isExtern = false;
@@ -64,7 +65,7 @@ bool Parser::buildFunction(Token startToken, std::string className) {
 
     // Make sure we have a function name
     token = scanner->getNext();
-    std::string funcName = token.id_val;
+    Symbol funcName = token.id_val;
     
     if (token.type != Id) {
         syntax->addError(scanner->getLine(), "Expected function name.");
@@ -95,7 +96,7 @@ bool Parser::buildFunction(Token startToken, std::string className) {
     }
 
     // Create the function object
-    funcs.push_back(funcName);
+    funcs.insert(funcName);
     
     if (isExtern) {
         AstExternFunction *ex = new AstExternFunction(funcName);
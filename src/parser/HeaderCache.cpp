@@ -0,0 +1,88 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <sys/stat.h>
+
+#include <parser/HeaderCache.hpp>
+#include <parser/Parser.hpp>
+#include <parser/Module.hpp>
+
+static std::mutex cacheLock;
+static std::map<std::string, std::shared_ptr<Header>> cache;
+
+// The headers being parsed on this thread, to catch circular imports
+static thread_local std::set<std::string> inProgress;
+
+// A header is only current if everything it imports is too
+static bool isCurrent(Header *header) {
+    struct stat info;
+    if (stat(header->path.c_str(), &info) == -1) return false;
+    if ((uint64_t)info.st_size != header->size) return false;
+    if (info.st_mtim.tv_sec != header->mtime.tv_sec || info.st_mtim.tv_nsec != header->mtime.tv_nsec) return false;
+    
+    for (auto &import : header->imports) {
+        if (!isCurrent(import.get())) return false;
+    }
+    return true;
+}
+
+static std::shared_ptr<Header> parseHeader(std::string path) {
+    struct stat info;
+    if (stat(path.c_str(), &info) == -1) return nullptr;
+    
+    std::unique_ptr<Source> source = Source::open(path);
+    if (!source) return nullptr;
+    
+    std::shared_ptr<Header> header = std::make_shared<Header>();
+    header->path = path;
+    header->size = info.st_size;
+    header->mtime = info.st_mtim;
+    
+    Parser *parser = new Parser(std::move(source), true);
+    bool parsed = parser->parse();
+    if (parsed) parser->exportHeader(header.get());
+    delete parser->getTree();       // The nodes live on in the header's arena
+    delete parser;
+    
+    if (!parsed) return nullptr;
+    return header;
+}
+
+std::shared_ptr<Header> getHeader(std::string path) {
+    {
+        std::lock_guard<std::mutex> lock(cacheLock);
+        auto entry = cache.find(path);
+        if (entry != cache.end() && isCurrent(entry->second.get())) return entry->second;
+    }
+    
+    if (inProgress.count(path)) {
+        std::cerr << "Fatal: Circular import: " << path << std::endl;
+        return nullptr;
+    }
+    
+    // Load or parse without holding the lock, since the header can import others.
+    // If two threads both miss, they both do the work, and the first one in wins
+    inProgress.insert(path);
+    std::shared_ptr<Header> header = readModule(path);
+    if (!header) header = parseHeader(path);
+    inProgress.erase(path);
+    
+    if (!header) return nullptr;
+    
+    std::lock_guard<std::mutex> lock(cacheLock);
+    auto entry = cache.find(path);
+    if (entry != cache.end() && isCurrent(entry->second.get())) return entry->second;
+    
+    cache[path] = header;
+    return header;
+}
+
+void clearHeaderCache() {
+    std::lock_guard<std::mutex> lock(cacheLock);
+    cache.clear();
+}
@@ -0,0 +1,48 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <ctime>
+#include <cstdint>
+
+#include <lex/Source.hpp>
+#include <ast/ast.hpp>
+
+//
+// The header cache
+// A header is lexed and parsed the first time something imports it, and what it
+// declares is kept for the rest of the process. Every unit after that (on any
+// thread, or in a later build on the compile server) gets the same declarations
+// without touching the file again, unless its mtime changes. The nodes are shared
+// between trees, so nothing may change them once they are in the cache.
+//
+// If the header has a current precompiled module (see Module.hpp), that is
+// loaded instead of parsing the header.
+//
+struct Header {
+    std::string path;
+    uint64_t size = 0;
+    timespec mtime;
+    std::unique_ptr<Source> source;     // The header's text, even if it was loaded from its module
+    std::shared_ptr<AstArena> arena;    // Holds the nodes below
+    
+    // What the header itself declares; anything it imports is in its own entry
+    std::vector<AstGlobalStatement *> globals;
+    std::vector<AstStruct *> structs;
+    std::map<Symbol, std::pair<AstDataType *, AstExpression *>> consts;
+    std::vector<std::shared_ptr<Header>> imports;
+};
+
+// Returns the header at path, parsing it if it isn't cached (or is out of date).
+// Returns nullptr if the header can't be read or doesn't parse.
+std::shared_ptr<Header> getHeader(std::string path);
+
+// Forgets every cached header. Trees that imported one keep it alive.
+void clearHeaderCache();
@@ -0,0 +1,428 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+// Module.cpp
+// Reads and writes precompiled headers
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <parser/Module.hpp>
+#include <ast/ast_builder.hpp>
+
+// Bump this whenever the layout (or V_AstType) changes
+static const char moduleMagic[4] = { 'T', 'L', 'M', '\0' };
+static const uint32_t moduleVersion = 1;
+
+// Marks a missing expression
+static const uint8_t noExpression = 0xFF;
+
+std::string getModulePath(std::string headerPath) {
+    if (headerPath.length() > 3 && headerPath.substr(headerPath.length() - 3) == ".th") {
+        headerPath = headerPath.substr(0, headerPath.length() - 3);
+    }
+    return headerPath + ".tlm";
+}
+
+//
+// Writing
+//
+class ModuleWriter {
+public:
+    void writeU8(uint8_t val) { buffer.push_back((char)val); }
+    void writeU32(uint32_t val) { buffer.append((const char *)&val, sizeof(val)); }
+    void writeU64(uint64_t val) { buffer.append((const char *)&val, sizeof(val)); }
+    
+    void writeString(std::string val) {
+        writeU32(val.length());
+        buffer += val;
+    }
+    
+    void writeType(AstDataType *dataType);
+    bool writeExpression(AstExpression *expr);
+    
+    std::string buffer = "";
+};
+
+void ModuleWriter::writeType(AstDataType *dataType) {
+    writeU8((uint8_t)dataType->getType());
+    writeU8(dataType->isUnsigned());
+    
+    switch (dataType->getType()) {
+        case V_AstType::Ptr: writeType(static_cast<AstPointerType *>(dataType)->getBaseType()); break;
+        case V_AstType::Struct: writeString(static_cast<AstStructType *>(dataType)->getName().str()); break;
+        default: {}
+    }
+}
+
+bool ModuleWriter::writeExpression(AstExpression *expr) {
+    if (expr == nullptr) {
+        writeU8(noExpression);
+        return true;
+    }
+    
+    writeU8((uint8_t)expr->getType());
+    
+    switch (expr->getType()) {
+        case V_AstType::CharL: writeU8(static_cast<AstChar *>(expr)->getValue()); break;
+        case V_AstType::I8L: writeU8(static_cast<AstI8 *>(expr)->getValue()); break;
+        case V_AstType::I16L: writeU32(static_cast<AstI16 *>(expr)->getValue()); break;
+        case V_AstType::I32L: writeU64(static_cast<AstI32 *>(expr)->getValue()); break;
+        case V_AstType::I64L: writeU64(static_cast<AstI64 *>(expr)->getValue()); break;
+        case V_AstType::StringL: writeString(static_cast<AstString *>(expr)->getValue().str()); break;
+        case V_AstType::ID: writeString(static_cast<AstID *>(expr)->getValue().str()); break;
+        
+        case V_AstType::Neg: return writeExpression(static_cast<AstNegOp *>(expr)->getVal());
+        
+        case V_AstType::ExprList: {
+            AstExprList *list = static_cast<AstExprList *>(expr);
+            writeU32(list->getList().size());
+            for (auto item : list->getList()) {
+                if (!writeExpression(item)) return false;
+            }
+        } break;
+        
+        case V_AstType::Assign:
+        case V_AstType::Add:
+        case V_AstType::Sub:
+        case V_AstType::Mul:
+        case V_AstType::Div:
+        case V_AstType::Mod:
+        case V_AstType::And:
+        case V_AstType::Or:
+        case V_AstType::Xor:
+        case V_AstType::EQ:
+        case V_AstType::NEQ:
+        case V_AstType::GT:
+        case V_AstType::LT:
+        case V_AstType::GTE:
+        case V_AstType::LTE:
+        case V_AstType::LogicalAnd:
+        case V_AstType::LogicalOr: {
+            AstBinaryOp *op = static_cast<AstBinaryOp *>(expr);
+            if (!writeExpression(op->getLVal())) return false;
+            return writeExpression(op->getRVal());
+        }
+        
+        // Constants can't refer to variables or call functions
+        default: return false;
+    }
+    
+    return true;
+}
+
+bool writeModule(Header *header, std::string path) {
+    ModuleWriter writer;
+    writer.buffer.append(moduleMagic, sizeof(moduleMagic));
+    writer.writeU32(moduleVersion);
+    
+    // The header this came from
+    writer.writeU64(header->size);
+    writer.writeU64(header->mtime.tv_sec);
+    writer.writeU64(header->mtime.tv_nsec);
+    
+    writer.writeU32(header->imports.size());
+    for (auto &import : header->imports) writer.writeString(import->path);
+    
+    writer.writeU32(header->structs.size());
+    for (AstStruct *str : header->structs) {
+        writer.writeString(str->getName().str());
+        writer.writeU32(str->getItems().size());
+        for (Var var : str->getItems()) {
+            writer.writeString(var.name.str());
+            writer.writeType(var.type);
+            if (!writer.writeExpression(str->getDefaultExpression(var.name))) {
+                std::cerr << "Error: Unsupported default value for " << str->getName() << "." << var.name << std::endl;
+                return false;
+            }
+        }
+    }
+    
+    writer.writeU32(header->consts.size());
+    for (auto &constant : header->consts) {
+        writer.writeString(constant.first.str());
+        writer.writeType(constant.second.first);
+        if (!writer.writeExpression(constant.second.second)) {
+            std::cerr << "Error: Unsupported value for constant " << constant.first << std::endl;
+            return false;
+        }
+    }
+    
+    writer.writeU32(header->globals.size());
+    for (AstGlobalStatement *global : header->globals) {
+        if (global->getType() != V_AstType::ExternFunc) {
+            std::cerr << "Error: Only declarations can go in a module: " << header->path << std::endl;
+            return false;
+        }
+        
+        AstExternFunction *func = static_cast<AstExternFunction *>(global);
+        writer.writeString(func->getName().str());
+        writer.writeU8(func->isVarArgs());
+        writer.writeType(func->getDataType());
+        writer.writeU32(func->getArguments().size());
+        for (Var arg : func->getArguments()) {
+            writer.writeString(arg.name.str());
+            writer.writeType(arg.type);
+        }
+    }
+    
+    // Write to the side and move it in, so nobody maps half a module
+    std::string tempPath = path + "." + std::to_string(getpid()) + ".tmp";
+    std::ofstream file(tempPath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: Unable to write module: " << path << std::endl;
+        return false;
+    }
+    file.write(writer.buffer.data(), writer.buffer.length());
+    file.close();
+    
+    if (!file || rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Error: Unable to write module: " << path << std::endl;
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+//
+// Reading
+// Everything is bounds-checked; a short or corrupt module just fails to load
+//
+class ModuleReader {
+public:
+    explicit ModuleReader(const char *pos, const char *end) {
+        this->pos = pos;
+        this->end = end;
+    }
+    
+    bool read(void *val, size_t size) {
+        if ((size_t)(end - pos) < size) return (ok = false);
+        memcpy(val, pos, size);
+        pos += size;
+        return true;
+    }
+    
+    uint8_t readU8() { uint8_t val = 0; read(&val, sizeof(val)); return val; }
+    uint32_t readU32() { uint32_t val = 0; read(&val, sizeof(val)); return val; }
+    uint64_t readU64() { uint64_t val = 0; read(&val, sizeof(val)); return val; }
+    
+    std::string readString() {
+        uint32_t length = readU32();
+        if (!ok || (size_t)(end - pos) < length) {
+            ok = false;
+            return "";
+        }
+        std::string val(pos, length);
+        pos += length;
+        return val;
+    }
+    
+    // Names go straight into the symbol table
+    Symbol readSymbol() {
+        uint32_t length = readU32();
+        if (!ok || (size_t)(end - pos) < length) {
+            ok = false;
+            return Symbol();
+        }
+        Symbol val(std::string_view(pos, length));
+        pos += length;
+        return val;
+    }
+    
+    AstDataType *readType();
+    AstExpression *readExpression();
+    
+    bool ok = true;
+private:
+    const char *pos;
+    const char *end;
+};
+
+AstDataType *ModuleReader::readType() {
+    V_AstType type = (V_AstType)readU8();
+    bool isUnsigned = readU8();
+    if (!ok) return nullptr;
+    
+    switch (type) {
+        case V_AstType::Void: return AstBuilder::buildVoidType();
+        case V_AstType::Bool: return AstBuilder::buildBoolType();
+        case V_AstType::Char: return AstBuilder::buildCharType();
+        case V_AstType::Int8: return AstBuilder::buildInt8Type(isUnsigned);
+        case V_AstType::Int16: return AstBuilder::buildInt16Type(isUnsigned);
+        case V_AstType::Int32: return AstBuilder::buildInt32Type(isUnsigned);
+        case V_AstType::Int64: return AstBuilder::buildInt64Type(isUnsigned);
+        case V_AstType::String: return AstBuilder::buildStringType();
+        
+        case V_AstType::Ptr: {
+            AstDataType *baseType = readType();
+            if (!baseType) return nullptr;
+            return AstBuilder::buildPointerType(baseType);
+        }
+        
+        case V_AstType::Struct: {
+            Symbol name = readSymbol();
+            if (!ok) return nullptr;
+            return AstBuilder::buildStructType(name);
+        }
+        
+        default: {}
+    }
+    
+    ok = false;
+    return nullptr;
+}
+
+static AstBinaryOp *buildBinaryOp(V_AstType type) {
+    switch (type) {
+        case V_AstType::Assign: return new AstAssignOp;
+        case V_AstType::Add: return new AstAddOp;
+        case V_AstType::Sub: return new AstSubOp;
+        case V_AstType::Mul: return new AstMulOp;
+        case V_AstType::Div: return new AstDivOp;
+        case V_AstType::Mod: return new AstModOp;
+        case V_AstType::And: return new AstAndOp;
+        case V_AstType::Or: return new AstOrOp;
+        case V_AstType::Xor: return new AstXorOp;
+        case V_AstType::EQ: return new AstEQOp;
+        case V_AstType::NEQ: return new AstNEQOp;
+        case V_AstType::GT: return new AstGTOp;
+        case V_AstType::LT: return new AstLTOp;
+        case V_AstType::GTE: return new AstGTEOp;
+        case V_AstType::LTE: return new AstLTEOp;
+        case V_AstType::LogicalAnd: return new AstLogicalAndOp;
+        case V_AstType::LogicalOr: return new AstLogicalOrOp;
+        default: {}
+    }
+    return nullptr;
+}
+
+AstExpression *ModuleReader::readExpression() {
+    uint8_t tag = readU8();
+    if (!ok || tag == noExpression) return nullptr;
+    
+    V_AstType type = (V_AstType)tag;
+    switch (type) {
+        case V_AstType::CharL: return new AstChar(readU8());
+        case V_AstType::I8L: return new AstI8(readU8());
+        case V_AstType::I16L: return new AstI16(readU32());
+        case V_AstType::I32L: return new AstI32(readU64());
+        case V_AstType::I64L: return new AstI64(readU64());
+        case V_AstType::StringL: return new AstString(readSymbol());
+        case V_AstType::ID: return new AstID(readSymbol());
+        
+        case V_AstType::Neg: {
+            AstNegOp *op = new AstNegOp;
+            op->setVal(readExpression());
+            return op;
+        }
+        
+        case V_AstType::ExprList: {
+            AstExprList *list = new AstExprList;
+            uint32_t count = readU32();
+            for (uint32_t i = 0; i<count && ok; i++) list->addExpression(readExpression());
+            return list;
+        }
+        
+        default: {
+            AstBinaryOp *op = buildBinaryOp(type);
+            if (!op) break;
+            
+            op->setLVal(readExpression());
+            op->setRVal(readExpression());
+            return op;
+        }
+    }
+    
+    ok = false;
+    return nullptr;
+}
+
+std::shared_ptr<Header> readModule(std::string headerPath) {
+    struct stat info;
+    if (stat(headerPath.c_str(), &info) == -1) return nullptr;
+    
+    std::unique_ptr<Source> source = Source::open(getModulePath(headerPath));
+    if (!source) return nullptr;
+    
+    ModuleReader reader(source->getData(), source->getData() + source->getSize());
+    char magic[sizeof(moduleMagic)];
+    if (!reader.read(magic, sizeof(magic)) || memcmp(magic, moduleMagic, sizeof(magic)) != 0) return nullptr;
+    if (reader.readU32() != moduleVersion) return nullptr;
+    
+    // Make sure this is still the header on disk
+    uint64_t size = reader.readU64();
+    uint64_t seconds = reader.readU64();
+    uint64_t nanoseconds = reader.readU64();
+    if (!reader.ok) return nullptr;
+    if (size != (uint64_t)info.st_size || seconds != (uint64_t)info.st_mtim.tv_sec
+        || nanoseconds != (uint64_t)info.st_mtim.tv_nsec) {
+        return nullptr;
+    }
+    
+    std::shared_ptr<Header> header = std::make_shared<Header>();
+    header->path = headerPath;
+    header->size = info.st_size;
+    header->mtime = info.st_mtim;
+    header->arena = std::make_shared<AstArena>();
+    AstArena::Scope arena(header->arena.get());
+    
+    uint32_t count = reader.readU32();
+    for (uint32_t i = 0; i<count && reader.ok; i++) {
+        std::shared_ptr<Header> import = getHeader(reader.readString());
+        if (!import) return nullptr;
+        header->imports.push_back(import);
+    }
+    
+    count = reader.readU32();
+    for (uint32_t i = 0; i<count && reader.ok; i++) {
+        AstStruct *str = new AstStruct(reader.readSymbol());
+        
+        uint32_t items = reader.readU32();
+        for (uint32_t j = 0; j<items && reader.ok; j++) {
+            Symbol name = reader.readSymbol();
+            AstDataType *dataType = reader.readType();
+            AstExpression *expr = reader.readExpression();
+            if (!reader.ok) break;
+            
+            str->addItem(Var(dataType, name), expr);
+        }
+        
+        header->structs.push_back(str);
+    }
+    
+    count = reader.readU32();
+    for (uint32_t i = 0; i<count && reader.ok; i++) {
+        Symbol name = reader.readSymbol();
+        AstDataType *dataType = reader.readType();
+        AstExpression *expr = reader.readExpression();
+        header->consts[name] = std::pair<AstDataType *, AstExpression *>(dataType, expr);
+    }
+    
+    count = reader.readU32();
+    for (uint32_t i = 0; i<count && reader.ok; i++) {
+        AstExternFunction *func = new AstExternFunction(reader.readSymbol());
+        if (reader.readU8()) func->setVarArgs();
+        func->setDataType(reader.readType());
+        
+        uint32_t args = reader.readU32();
+        for (uint32_t j = 0; j<args && reader.ok; j++) {
+            Symbol name = reader.readSymbol();
+            AstDataType *dataType = reader.readType();
+            func->addArgument(Var(dataType, name));
+        }
+        
+        header->globals.push_back(func);
+    }
+    
+    if (!reader.ok) return nullptr;
+    
+    // The object cache hashes the header's text, so keep that rather than the module
+    header->source = Source::open(headerPath);
+    if (!header->source) return nullptr;
+    return header;
+}
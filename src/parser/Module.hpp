@@ -0,0 +1,31 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#pragma once
+
+#include <string>
+#include <memory>
+
+#include <parser/HeaderCache.hpp>
+
+//
+// Precompiled modules
+// A module (.tlm) is a header's declarations in binary form: the extern function
+// signatures, the struct layouts, and the global constants, along with the
+// headers it imports. It sits next to the header, and records the size and
+// mtime of the header it came from; the header cache maps a current module in
+// place of lexing and parsing the header.
+//
+
+// Returns where the module for a header goes (foo.th -> foo.tlm)
+std::string getModulePath(std::string headerPath);
+
+// Writes a module for a parsed header. Returns false if the header has
+// something a module can't hold (function bodies), or on an I/O error
+bool writeModule(Header *header, std::string path);
+
+// Loads the module for a header. Returns nullptr if there is no module, or if
+// it doesn't match the header on disk
+std::shared_ptr<Header> readModule(std::string headerPath);
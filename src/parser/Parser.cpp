@@ -12,62 +12,89 @@
 Parser::Parser(std::string input) {
     this->input = input;
     scanner = new Scanner(input);
-    
+    init();
+}
+
+// Parses a buffer from the preprocessor (or a mapped file)
+Parser::Parser(std::unique_ptr<Source> source, bool isHeader) {
+    this->input = source->getName();
+    this->isHeader = isHeader;
+    this->source = std::move(source);
+    scanner = new Scanner(this->source.get());
+    init();
+}
+
+void Parser::init() {
     tree = new AstTree(input);
     syntax = new ErrorManager;
     
+    AstArena::Scope arena(tree->getArena().get());
+    
+    scanner->setImportHandler([this](std::string path) {
+        return importHeader(path);
+    });
+    scanner->setErrorHandler([this](int line, std::string message) {
+        syntax->addError(line, message);
+    });
+    
+    // The built-in functions go in the unit, not in each header
+    if (isHeader) {
+        syntax->setFile(input);
+        return;
+    }
+    
     // Add the built-in functions
     //string malloc(string)
-    funcs.push_back("malloc");
-    AstExternFunction *FT1 = new AstExternFunction("malloc");
-    FT1->addArgument(Var(AstBuilder::buildInt32Type(), "size"));
+    funcs.insert(Symbol("malloc"));
+    AstExternFunction *FT1 = new AstExternFunction(Symbol("malloc"));
+    FT1->addArgument(Var(AstBuilder::buildInt32Type(), Symbol("size")));
     FT1->setDataType(AstBuilder::buildStringType());
     tree->addGlobalStatement(FT1);
     
     //println(string)
-    funcs.push_back("println");
-    AstExternFunction *FT2 = new AstExternFunction("println");
+    funcs.insert(Symbol("println"));
+    AstExternFunction *FT2 = new AstExternFunction(Symbol("println"));
     FT2->setVarArgs();
-    FT2->addArgument(Var(AstBuilder::buildStringType(), "str"));
+    FT2->addArgument(Var(AstBuilder::buildStringType(), Symbol("str")));
     FT2->setDataType(AstBuilder::buildVoidType());
     tree->addGlobalStatement(FT2);
     
     //print(string)
-    funcs.push_back("print");
-    AstExternFunction *FT3 = new AstExternFunction("print");
+    funcs.insert(Symbol("print"));
+    AstExternFunction *FT3 = new AstExternFunction(Symbol("print"));
     FT3->setVarArgs();
-    FT3->addArgument(Var(AstBuilder::buildStringType(), "str"));
+    FT3->addArgument(Var(AstBuilder::buildStringType(), Symbol("str")));
     FT3->setDataType(AstBuilder::buildVoidType());
     tree->addGlobalStatement(FT3);
     
     //i32 strlen(string)
-    funcs.push_back("strlen");
-    AstExternFunction *FT4 = new AstExternFunction("strlen");
-    FT4->addArgument(Var(AstBuilder::buildStringType(), "str"));
+    funcs.insert(Symbol("strlen"));
+    AstExternFunction *FT4 = new AstExternFunction(Symbol("strlen"));
+    FT4->addArgument(Var(AstBuilder::buildStringType(), Symbol("str")));
     FT4->setDataType(AstBuilder::buildInt32Type());
     tree->addGlobalStatement(FT4);
     
     //i32 stringcmp(string, string)
-    funcs.push_back("stringcmp");
-    AstExternFunction *FT5 = new AstExternFunction("stringcmp");
-    FT5->addArgument(Var(AstBuilder::buildStringType(), "str"));
-    FT5->addArgument(Var(AstBuilder::buildStringType(), "str"));
+    funcs.insert(Symbol("stringcmp"));
+    AstExternFunction *FT5 = new AstExternFunction(Symbol("stringcmp"));
+    FT5->addArgument(Var(AstBuilder::buildStringType(), Symbol("str")));
+    FT5->addArgument(Var(AstBuilder::buildStringType(), Symbol("str")));
     FT5->setDataType(AstBuilder::buildInt32Type());
     tree->addGlobalStatement(FT5);
     
     //string strcat_str(string, string)
-    funcs.push_back("strcat_str");
-    AstExternFunction *FT6 = new AstExternFunction("strcat_str");
-    FT6->addArgument(Var(AstBuilder::buildStringType(), "str"));
-    FT6->addArgument(Var(AstBuilder::buildStringType(), "str"));
+    funcs.insert(Symbol("strcat_str"));
+    AstExternFunction *FT6 = new AstExternFunction(Symbol("strcat_str"));
+    FT6->addArgument(Var(AstBuilder::buildStringType(), Symbol("str")));
+    FT6->addArgument(Var(AstBuilder::buildStringType(), Symbol("str")));
     FT6->setDataType(AstBuilder::buildStringType());
     tree->addGlobalStatement(FT6);
     
     //string strcat_char(string, char)
-    funcs.push_back("strcat_char");
-    AstExternFunction *FT7 = new AstExternFunction("strcat_char");
-    FT7->addArgument(Var(AstBuilder::buildStringType(), "str"));
-    FT7->addArgument(Var(AstBuilder::buildCharType(), "c"));
+    funcs.insert(Symbol("strcat_char"));
+    AstExternFunction *FT7 = new AstExternFunction(Symbol("strcat_char"));
+    FT7->addArgument(Var(AstBuilder::buildStringType(), Symbol("str")));
+    FT7->addArgument(Var(AstBuilder::buildCharType(), Symbol("c")));
     FT7->setDataType(AstBuilder::buildStringType());
     tree->addGlobalStatement(FT7);
 }
@@ -78,6 +105,8 @@ Parser::~Parser() {
 }
 
 bool Parser::parse() {
+    AstArena::Scope arena(tree->getArena().get());
+    
     Token token;
     do {
         token = scanner->getNext();
@@ -104,6 +133,9 @@ bool Parser::parse() {
         if (!code) break;
     } while (token.type != Eof);
     
+    // An import that couldn't be read leaves the scanner in an error state
+    if (scanner->isError()) return false;
+    
     // Check for errors, and print if so
     if (syntax->errorsPresent()) {
         syntax->printErrors();
@@ -115,30 +147,36 @@ bool Parser::parse() {
 }
 
 // Builds a statement block
+// Each block is a scope. An error ends the parse, so the scope is only closed
+// on the way out of a block that parsed.
 bool Parser::buildBlock(AstBlock *block, AstNode *parent) {
-    Token token = scanner->getNext();
+    locals.enterScope();
+    
+    Token token = scanner->peek();
     while (token.type != End && token.type != Eof) {
         bool code = true;
         bool end = false;
         
+        // An assignment is parsed as an expression, so an identifier stays put
+        // until we know which kind of statement it starts
+        if (token.type != Id) scanner->consume();
+        
         switch (token.type) {
             case VarD: code = buildVariableDec(block); break;
             case Struct: code = buildStructDec(block); break;
             case Const: code = buildConst(false); break;
             
             case Id: {
-                Token idToken = token;
-                token = scanner->getNext();
+                TokenType next = scanner->peek(1).type;
                 
-                if (token.type == Assign || token.type == LBracket || token.type == Dot) {
-                    scanner->rewind(token);
-                    scanner->rewind(idToken);
-                    code = buildVariableAssign(block, idToken);
-                } else if (token.type == LParen) {
-                    code = buildFunctionCallStmt(block, idToken);
+                if (next == Assign || next == LBracket || next == Dot) {
+                    code = buildVariableAssign(block, token);
+                } else if (next == LParen) {
+                    scanner->consume(2);
+                    code = buildFunctionCallStmt(block, token);
                 } else {
                     syntax->addError(scanner->getLine(), "Invalid use of identifier.");
-                    token.print();
+                    scanner->peek(1).print();
                     return false;
                 }
             } break;
@@ -147,12 +185,15 @@ bool Parser::buildBlock(AstBlock *block, AstNode *parent) {
             
             // Handle conditionals
             case If: code = buildConditional(block); break;
+            // These end the true block, so its scope is closed first
             case Elif: {
+                locals.exitScope();
                 AstIfStmt *condParent = static_cast<AstIfStmt *>(parent);
                 code = buildConditional(condParent->getFalseBlock());
                 end = true;
             } break;
             case Else: {
+                locals.exitScope();
                 AstIfStmt *condParent = static_cast<AstIfStmt *>(parent);
                 buildBlock(condParent->getFalseBlock());
                 end = true;
@@ -170,11 +211,14 @@ bool Parser::buildBlock(AstBlock *block, AstNode *parent) {
             }
         }
         
-        if (end) break;
+        if (end) return true;
         if (!code) return false;
-        token = scanner->getNext();
+        token = scanner->peek();
     }
     
+    // The end of the block
+    scanner->consume();
+    locals.exitScope();
     return true;
 }
 
@@ -211,7 +255,79 @@ AstExpression *Parser::checkExpression(AstExpression *expr, AstDataType *varType
     return expr;
 }
 
-// The debug function for the scanner
+std::vector<Source *> Parser::getSources() {
+    std::vector<Source *> sources;
+    if (source) sources.push_back(source.get());
+    
+    for (auto &header : headers) sources.push_back(header->source.get());
+    return sources;
+}
+
+std::vector<std::string> Parser::getHeaderPaths() {
+    std::vector<std::string> paths;
+    for (auto &header : headers) paths.push_back(header->path);
+    return paths;
+}
+
+// Called by the scanner for each import line
+bool Parser::importHeader(std::string path) {
+    std::shared_ptr<Header> header = getHeader(path);
+    if (!header) return false;
+    
+    imports.push_back(header);
+    addHeader(header);
+    return true;
+}
+
+// Adds the declarations from a header (and whatever it imports) to the unit
+void Parser::addHeader(std::shared_ptr<Header> header) {
+    if (!headerPaths.insert(header->path).second) return;
+    
+    for (auto &import : header->imports) addHeader(import);
+    headers.push_back(header);
+    tree->keepArena(header->arena);
+    
+    for (AstGlobalStatement *global : header->globals) {
+        if (global->getType() == V_AstType::ExternFunc) {
+            funcs.insert(static_cast<AstExternFunction *>(global)->getName());
+        } else if (global->getType() == V_AstType::Func) {
+            funcs.insert(static_cast<AstFunction *>(global)->getName());
+        }
+        
+        tree->addGlobalStatement(global);
+        headerNodes.insert(global);
+    }
+    
+    for (AstStruct *str : header->structs) {
+        tree->addStruct(str);
+        headerNodes.insert(str);
+    }
+    
+    for (auto &constant : header->consts) {
+        globalConsts[constant.first] = constant.second;
+        headerConsts.insert(constant.first);
+    }
+}
+
+// Everything in the tree that didn't come from another header belongs to this one
+void Parser::exportHeader(Header *header) {
+    header->source = std::move(source);
+    header->arena = tree->getArena();
+    header->imports = imports;
+    
+    for (AstGlobalStatement *global : tree->getGlobalStatements()) {
+        if (headerNodes.count(global) == 0) header->globals.push_back(global);
+    }
+    
+    for (AstStruct *str : tree->getStructs()) {
+        if (headerNodes.count(str) == 0) header->structs.push_back(str);
+    }
+    
+    for (auto &constant : globalConsts) {
+        if (headerConsts.count(constant.first) == 0) header->consts[constant.first] = constant.second;
+    }
+}
+
 void Parser::debugScanner() {
     std::cout << "Debugging scanner..." << std::endl;
     
@@ -222,31 +338,33 @@ void Parser::debugScanner() {
     } while (t.type != Eof);
 }
 
-// Checks to see if a string is a constant
-int Parser::isConstant(std::string name) {
+// Checks to see if a name is a constant; 1 is global and 2 is local.
+// A local variable shadows a global constant.
+int Parser::isConstant(Symbol name) {
+    LocalName *local = locals.find(name);
+    if (local) return local->value ? 2 : 0;
+    
     if (globalConsts.find(name) != globalConsts.end()) {
         return 1;
     }
     
-    if (localConsts.find(name) != localConsts.end()) {
-        return 2;
-    }
-    
     return 0;
 }
 
-bool Parser::isVar(std::string name) {
-    if (std::find(vars.begin(), vars.end(), name) != vars.end()) {
-        return true;
-    }
-    return false;
+bool Parser::isVar(Symbol name) {
+    LocalName *local = locals.find(name);
+    return local && !local->value;
 }
 
-bool Parser::isFunc(std::string name) {
-    if (std::find(funcs.begin(), funcs.end(), name) != funcs.end()) {
-        return true;
-    }
-    return false;
+// Returns the type of a variable or local constant in scope, or nullptr
+AstDataType *Parser::getVarType(Symbol name) {
+    LocalName *local = locals.find(name);
+    if (!local) return nullptr;
+    return local->type;
+}
+
+bool Parser::isFunc(Symbol name) {
+    return funcs.count(name) > 0;
 }
 
 //
@@ -270,15 +388,7 @@ AstDataType *Parser::buildDataType(bool checkBrackets) {
         case Str: dataType = AstBuilder::buildStringType(); break;
         
         case Id: {
-            bool isStruct = false;
-            for (auto s : tree->getStructs()) {
-                if (s->getName() == token.id_val) {
-                    isStruct = true;
-                    break;
-                }
-            }
-                
-            if (isStruct) {
+            if (tree->hasStruct(token.id_val)) {
                 dataType = AstBuilder::buildStructType(token.id_val);
             }
         } break;
@@ -286,19 +396,15 @@ AstDataType *Parser::buildDataType(bool checkBrackets) {
         default: {}
     }
 
-    if (checkBrackets) {
+    if (checkBrackets && scanner->peek().type == LBracket) {
+        scanner->consume();
         token = scanner->getNext();
-        if (token.type == LBracket) {
-            token = scanner->getNext();
-            if (token.type != RBracket) {
-                syntax->addError(scanner->getLine(), "Invalid pointer type.");
-                return nullptr;
-            }
-            
-            dataType = AstBuilder::buildPointerType(dataType);
-        } else {
-            scanner->rewind(token);
+        if (token.type != RBracket) {
+            syntax->addError(scanner->getLine(), "Invalid pointer type.");
+            return nullptr;
         }
+        
+        dataType = AstBuilder::buildPointerType(dataType);
     }
     
     return dataType;
@@ -7,9 +7,16 @@
 
 #include <string>
 #include <map>
+#include <set>
+#include <stack>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
 
-#include <lex.hpp>
+#include <lex/lex.hpp>
 #include <parser/ErrorManager.hpp>
+#include <parser/HeaderCache.hpp>
+#include <parser/Scope.hpp>
 #include <ast/ast.hpp>
 
 // The parser class
@@ -19,12 +26,22 @@
 class Parser {
 public:
     explicit Parser(std::string input);
+    explicit Parser(std::unique_ptr<Source> source, bool isHeader = false);
     ~Parser();
     
     bool parse();
     
     AstTree *getTree() { return tree; }
     
+    // The file being parsed, and then every header it imported
+    std::vector<Source *> getSources();
+    
+    // The path of every header imported, directly or not
+    std::vector<std::string> getHeaderPaths();
+    
+    // Hands what a header declared over to the header cache
+    void exportHeader(Header *header);
+    
     void debugScanner();
 protected:
     // Function.cpp
@@ -66,20 +83,33 @@ protected:
     
     bool buildBlock(AstBlock *block, AstNode *parent = nullptr);
     AstExpression *checkCondExpression(AstExpression *toCheck);
-    int isConstant(std::string name);
-    bool isVar(std::string name);
-    bool isFunc(std::string name);
+    int isConstant(Symbol name);
+    bool isVar(Symbol name);
+    bool isFunc(Symbol name);
+    AstDataType *getVarType(Symbol name);
     AstDataType *buildDataType(bool checkBrackets = true);
 private:
+    void init();
+    bool importHeader(std::string path);
+    void addHeader(std::shared_ptr<Header> header);
+    
     std::string input = "";
+    bool isHeader = false;
+    std::unique_ptr<Source> source;
     Scanner *scanner;
     AstTree *tree;
     ErrorManager *syntax;
     
-    std::map<std::string, AstDataType *> typeMap;
-    std::map<std::string, std::pair<AstDataType *, AstExpression*>> globalConsts;
-    std::map<std::string, std::pair<AstDataType *, AstExpression*>> localConsts;
-    std::vector<std::string> vars;
-    std::vector<std::string> funcs;
+    // Everything is keyed by the symbol the scanner gave the name
+    std::unordered_map<Symbol, std::pair<AstDataType *, AstExpression*>> globalConsts;
+    std::unordered_set<Symbol> funcs;
+    ScopeTable locals;              // Variables and constants in the current function
+    
+    // Imports; each header is only added once, however many times it's imported
+    std::vector<std::shared_ptr<Header>> imports;       // Just the ones in this file
+    std::vector<std::shared_ptr<Header>> headers;       // Everything, in order
+    std::set<std::string> headerPaths;
+    std::set<AstNode *> headerNodes;
+    std::set<Symbol> headerConsts;
 };
 
@@ -0,0 +1,61 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#include <parser/Scope.hpp>
+
+void ScopeTable::enterScope() {
+    scopes.push_back(undo.size());
+}
+
+// Puts back everything the scope's declarations shadowed, newest first
+void ScopeTable::exitScope() {
+    if (scopes.empty()) return;
+    
+    size_t start = scopes.back();
+    scopes.pop_back();
+    
+    while (undo.size() > start) {
+        Shadowed &entry = undo.back();
+        if (entry.wasDeclared) names[entry.name] = entry.previous;
+        else names.erase(entry.name);
+        undo.pop_back();
+    }
+}
+
+void ScopeTable::clear() {
+    names.clear();
+    undo.clear();
+    scopes.clear();
+}
+
+void ScopeTable::declare(Symbol name, LocalName local) {
+    local.depth = scopes.size();
+    auto entry = names.find(name);
+    
+    Shadowed shadowed;
+    shadowed.name = name;
+    shadowed.wasDeclared = entry != names.end();
+    if (shadowed.wasDeclared) {
+        shadowed.previous = entry->second;
+        entry->second = local;
+    } else {
+        names[name] = local;
+    }
+    
+    undo.push_back(shadowed);
+}
+
+// Whatever the innermost scope declares shadows everything else, so the
+// visible entry is the one to check
+bool ScopeTable::isDeclaredInScope(Symbol name) {
+    LocalName *local = find(name);
+    return local != nullptr && local->depth == scopes.size();
+}
+
+LocalName *ScopeTable::find(Symbol name) {
+    auto entry = names.find(name);
+    if (entry == names.end()) return nullptr;
+    return &entry->second;
+}
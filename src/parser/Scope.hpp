@@ -0,0 +1,55 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+
+#include <lex/Symbol.hpp>
+#include <ast/ast.hpp>
+
+// A variable or local constant
+struct LocalName {
+    AstDataType *type = nullptr;
+    AstExpression *value = nullptr;     // Only set for constants
+    size_t depth = 0;                   // How many scopes were open when it was declared
+};
+
+//
+// The local scopes
+// A function opens a scope for its arguments, and every block in it (function
+// body, if/elif/else, while) opens one nested inside that. A declaration can
+// shadow a name from an enclosing scope, and is gone at the end of its block.
+//
+// There is only one hash table: a declaration saves whatever it shadowed, and
+// leaving the scope puts that back. A lookup is one probe however deep the
+// nesting is. Each name also records the depth it was declared at, so checking
+// for a redeclaration is one probe too.
+//
+class ScopeTable {
+public:
+    void enterScope();
+    void exitScope();
+    void clear();
+    
+    void declare(Symbol name, LocalName local);
+    
+    // True if the innermost scope already declares the name
+    bool isDeclaredInScope(Symbol name);
+    
+    // Returns nullptr if the name isn't declared in any open scope
+    LocalName *find(Symbol name);
+private:
+    struct Shadowed {
+        Symbol name;
+        LocalName previous;
+        bool wasDeclared;
+    };
+    
+    std::unordered_map<Symbol, LocalName> names;
+    std::vector<Shadowed> undo;
+    std::vector<size_t> scopes;         // Where each open scope starts in undo
+};
@@ -14,7 +14,7 @@
 // Parses and builds a structure
 bool Parser::buildStruct() {
     Token token = scanner->getNext();
-    std::string name = token.id_val;
+    Symbol name = token.id_val;
     
     if (token.type != Id) {
         syntax->addError(scanner->getLine(), "Expected name for struct.");
@@ -42,7 +42,7 @@ bool Parser::buildStruct() {
 }
 
 bool Parser::buildStructMember(AstStruct *str, Token token) {
-    std::string valName = token.id_val;
+    Symbol valName = token.id_val;
     
     if (token.type != Id) {
         syntax->addError(scanner->getLine(), "Expected id value.");
@@ -83,13 +83,18 @@ bool Parser::buildStructMember(AstStruct *str, Token token) {
 
 bool Parser::buildStructDec(AstBlock *block) {
     Token token = scanner->getNext();
-    std::string name = token.id_val;
+    Symbol name = token.id_val;
     
     if (token.type != Id) {
         syntax->addError(scanner->getLine(), "Expected structure name.");
         return false;
     }
     
+    if (locals.isDeclaredInScope(name)) {
+        syntax->addError(scanner->getLine(), "Variable already declared in this scope.");
+        return false;
+    }
+    
     token = scanner->getNext();
     if (token.type != Colon) {
         syntax->addError(scanner->getLine(), "Expected \':\'");
@@ -97,7 +102,7 @@ bool Parser::buildStructDec(AstBlock *block) {
     }
     
     token = scanner->getNext();
-    std::string structName = token.id_val;
+    Symbol structName = token.id_val;
     
     if (token.type != Id) {
         syntax->addError(scanner->getLine(), "Expected structure type.");
@@ -105,23 +110,15 @@ bool Parser::buildStructDec(AstBlock *block) {
     }
     
     // Make sure the given structure exists
-    AstStruct *str = nullptr;
-    
-    for (auto s : tree->getStructs()) {
-        if (s->getName() == structName) {
-            str = s;
-            break;
-        }    
-    }
-    
-    if (str == nullptr) {
+    if (!tree->hasStruct(structName)) {
         syntax->addError(scanner->getLine(), "Unknown structure.");
         return false;
     }
     
     // Now build the declaration and push back
-    vars.push_back(name);
-    typeMap[name] = AstBuilder::buildStructType(structName);
+    LocalName local;
+    local.type = AstBuilder::buildStructType(structName);
+    locals.declare(name, local);
     AstStructDec *dec = new AstStructDec(name, structName);
     block->addStatement(dec);
     
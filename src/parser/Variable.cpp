@@ -6,6 +6,7 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <algorithm>
 
 #include <parser/Parser.hpp>
 #include <ast/ast.hpp>
@@ -15,7 +16,7 @@
 // A variable declaration is composed of an Alloca and optionally, an assignment
 bool Parser::buildVariableDec(AstBlock *block) {
     Token token = scanner->getNext();
-    std::vector<std::string> toDeclare;
+    std::vector<Symbol> toDeclare;
     toDeclare.push_back(token.id_val);
     
     if (token.type != Id) {
@@ -34,6 +35,12 @@ bool Parser::buildVariableDec(AstBlock *block) {
                 return false;
             }
             
+            // The same name twice in one list is a redeclaration too
+            if (std::find(toDeclare.begin(), toDeclare.end(), token.id_val) != toDeclare.end()) {
+                syntax->addError(scanner->getLine(), "Variable already declared in this scope.");
+                return false;
+            }
+            
             toDeclare.push_back(token.id_val);
         } else if (token.type != Colon) {
             syntax->addError(scanner->getLine(), "Invalid token in variable declaration.");
@@ -43,13 +50,21 @@ bool Parser::buildVariableDec(AstBlock *block) {
         token = scanner->getNext();
     }
     
+    // An inner block can shadow a name, but one block can't declare it twice
+    for (Symbol name : toDeclare) {
+        if (locals.isDeclaredInScope(name)) {
+            syntax->addError(scanner->getLine(), "Variable already declared in this scope.");
+            return false;
+        }
+    }
+    
     AstDataType *dataType = buildDataType(false);
     token = scanner->getNext();
     
     // We have an array
     if (token.type == LBracket) {
         dataType = AstBuilder::buildPointerType(dataType);
-        AstVarDec *empty = new AstVarDec("", dataType);
+        AstVarDec *empty = new AstVarDec(Symbol(), dataType);
         AstExpression *arg = buildExpression(AstBuilder::buildInt32Type(), RBracket);
         if (!arg) return false;
         empty->setExpression(arg); 
@@ -60,8 +75,7 @@ bool Parser::buildVariableDec(AstBlock *block) {
             return false;
         }
         
-        for (std::string name : toDeclare) {
-            vars.push_back(name);
+        for (Symbol name : toDeclare) {
             AstVarDec *vd = new AstVarDec(name, dataType);
             block->addStatement(vd);
             vd->setExpression(empty->getExpression());
@@ -72,7 +86,7 @@ bool Parser::buildVariableDec(AstBlock *block) {
             block->addStatement(va);
             
             AstID *id = new AstID(name);
-            AstFuncCallExpr *callMalloc = new AstFuncCallExpr("malloc");
+            AstFuncCallExpr *callMalloc = new AstFuncCallExpr(Symbol("malloc"));
             AstAssignOp *assign = new AstAssignOp(id, callMalloc);
             
             va->setExpression(assign);
@@ -97,7 +111,9 @@ bool Parser::buildVariableDec(AstBlock *block) {
             // Finally, set the size of the declaration
             vd->setPtrSize(vd->getExpression());
             
-            typeMap[name] = dataType;
+            LocalName local;
+            local.type = dataType;
+            locals.declare(name, local);
         }
     
     // We're at the end of the declaration
@@ -110,12 +126,13 @@ bool Parser::buildVariableDec(AstBlock *block) {
         AstExpression *arg = buildExpression(dataType);
         if (!arg) return false;
     
-        for (std::string name : toDeclare) {
-            vars.push_back(name);
+        for (Symbol name : toDeclare) {
             AstVarDec *vd = new AstVarDec(name, dataType);
             block->addStatement(vd);
             
-            typeMap[name] = dataType;
+            LocalName local;
+            local.type = dataType;
+            locals.declare(name, local);
             
             AstID *id = new AstID(name);
             AstAssignOp *assign = new AstAssignOp(id, arg);
@@ -132,7 +149,7 @@ bool Parser::buildVariableDec(AstBlock *block) {
 
 // Builds a variable or an array assignment
 bool Parser::buildVariableAssign(AstBlock *block, Token idToken) {
-    AstDataType *dataType = typeMap[idToken.id_val];
+    AstDataType *dataType = getVarType(idToken.id_val);
     
     // TODO: This abomination is temporar
     AstExpression *expr = buildExpression(dataType);
@@ -149,7 +166,7 @@ bool Parser::buildVariableAssign(AstBlock *block, Token idToken) {
 // Builds a constant variable
 bool Parser::buildConst(bool isGlobal) {
     Token token = scanner->getNext();
-    std::string name = token.id_val;
+    Symbol name = token.id_val;
     
     // Make sure we have a name for our constant
     if (token.type != Id) {
@@ -157,6 +174,11 @@ bool Parser::buildConst(bool isGlobal) {
         return false;
     }
     
+    if (!isGlobal && locals.isDeclaredInScope(name)) {
+        syntax->addError(scanner->getLine(), "Constant already declared in this scope.");
+        return false;
+    }
+    
     // Syntax check
     token = scanner->getNext();
     if (token.type != Colon) {
@@ -182,7 +204,10 @@ bool Parser::buildConst(bool isGlobal) {
     if (isGlobal) {
         globalConsts[name] = std::pair<AstDataType *, AstExpression*>(dataType, expr);
     } else {
-        localConsts[name] = std::pair<AstDataType *, AstExpression*>(dataType, expr);
+        LocalName local;
+        local.type = dataType;
+        local.value = expr;
+        locals.declare(name, local);
     }
     
     return true;
@@ -7,5 +7,6 @@
 
 #include <string>
 
-std::string preprocessFile(std::string input, bool print = false);
-
+// Returns a file with its imports pasted in, for -E. The compiler itself doesn't
+// need this: the scanner reads the headers as it goes. Returns false on error.
+bool preprocessFile(std::string input, std::string &content);
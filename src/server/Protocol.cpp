@@ -0,0 +1,121 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#include <cstdlib>
+#include <cerrno>
+#include <unistd.h>
+
+#include <server/Server.hpp>
+
+const std::vector<std::string> FORWARDED_ENV = { "TLC_CACHE_DIR", "TMPDIR" };
+
+std::string getServerSocketPath() {
+    const char *path = getenv("TLC_SERVER");
+    if (path != nullptr && path[0] != 0) return std::string(path);
+    return "/tmp/tlc-" + std::to_string(getuid()) + ".sock";
+}
+
+bool writeAll(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t count = write(fd, data, size);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+bool readAll(int fd, char *data, size_t size) {
+    while (size > 0) {
+        ssize_t count = read(fd, data, size);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+// Copies one stream of a reply (see above) from the socket to a file descriptor
+bool copyStream(int from, int to) {
+    uint64_t size = 0;
+    if (!readAll(from, (char *)&size, sizeof(size))) return false;
+    
+    char buffer[4096];
+    while (size > 0) {
+        size_t count = size < sizeof(buffer) ? size : sizeof(buffer);
+        if (!readAll(from, buffer, count)) return false;
+        writeAll(to, buffer, count);
+        size -= count;
+    }
+    return true;
+}
+
+// Strings in a request are length-prefixed, so any of them can be empty
+static void addString(std::string &request, std::string str) {
+    uint32_t size = str.size();
+    request.append((char *)&size, sizeof(size));
+    request += str;
+}
+
+static void addList(std::string &request, std::vector<std::string> list) {
+    uint32_t count = list.size();
+    request.append((char *)&count, sizeof(count));
+    for (std::string str : list) addString(request, str);
+}
+
+// Every size in a request comes from whoever connected, so the whole request
+// has to fit in this many bytes; anything bigger is refused before it's read
+static const size_t REQUEST_LIMIT = 1 << 20;
+
+static bool readSize(int fd, uint32_t &size, size_t &budget) {
+    if (budget < sizeof(size)) return false;
+    if (!readAll(fd, (char *)&size, sizeof(size))) return false;
+    budget -= sizeof(size);
+    return true;
+}
+
+static bool readString(int fd, std::string &str, size_t &budget) {
+    uint32_t size = 0;
+    if (!readSize(fd, size, budget)) return false;
+    if (size > budget) return false;
+    budget -= size;
+    
+    str.resize(size);
+    return readAll(fd, &str[0], size);
+}
+
+static bool readList(int fd, std::vector<std::string> &list, size_t &budget) {
+    uint32_t count = 0;
+    if (!readSize(fd, count, budget)) return false;
+    
+    // Each string takes at least its size, so a bigger count can't fit
+    if (count > budget / sizeof(uint32_t)) return false;
+    
+    list.clear();
+    for (uint32_t i = 0; i<count; i++) {
+        std::string str = "";
+        if (!readString(fd, str, budget)) return false;
+        list.push_back(str);
+    }
+    return true;
+}
+
+bool writeRequest(int fd, std::string cwd, std::vector<std::string> env, std::vector<std::string> args) {
+    std::string request = "";
+    addString(request, cwd);
+    addList(request, env);
+    addList(request, args);
+    
+    return writeAll(fd, request.data(), request.size());
+}
+
+bool readRequest(int fd, std::string &cwd, std::vector<std::string> &env, std::vector<std::string> &args) {
+    size_t budget = REQUEST_LIMIT;
+    return readString(fd, cwd, budget) && readList(fd, env, budget) && readList(fd, args, budget);
+}
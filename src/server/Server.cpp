@@ -0,0 +1,244 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#include <iostream>
+#include <exception>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+
+#include "llvm/Support/raw_ostream.h"
+
+#include <server/Server.hpp>
+#include <driver/Driver.hpp>
+#include <parser/HeaderCache.hpp>
+#include <ast/ast_builder.hpp>
+#include <lex/Symbol.hpp>
+
+// Symbols, and the cached headers and types that hold them, are kept from one
+// job to the next. Once there are this many, they are all dropped between jobs.
+static const size_t SYMBOL_LIMIT = 1 << 20;
+
+// Connections are handled one at a time, so a client that stops sending (or
+// reading) is dropped after this long rather than holding everyone else up
+static const int CLIENT_TIMEOUT = 10;       // In seconds
+
+// Set if a job left the server in the wrong directory; every later job would
+// then resolve its paths against it, so the server stops instead
+static bool lostCwd = false;
+
+// Running the program would put it inside the server, where a crash, an exit()
+// or a hang takes every other client down too
+static bool isRunningJob(std::vector<std::string> args) {
+    for (std::string arg : args) {
+        if (arg == "--") break;
+        if (arg == "--run" || arg.find("--bench") == 0) return true;
+    }
+    return false;
+}
+
+// The server's own value of a forwarded variable, to put back after a job
+struct SavedEnv {
+    std::string name;
+    std::string value;
+    bool isSet;
+};
+
+// Gives the job the client's values of the forwarded variables. One the client
+// didn't have set isn't set for the job either.
+static std::vector<SavedEnv> setJobEnv(std::vector<std::string> env) {
+    std::vector<SavedEnv> saved;
+    for (std::string name : FORWARDED_ENV) {
+        const char *value = getenv(name.c_str());
+        saved.push_back({ name, value ? value : "", value != nullptr });
+        unsetenv(name.c_str());
+    }
+    
+    for (std::string entry : env) {
+        size_t eq = entry.find('=');
+        if (eq == std::string::npos) continue;
+        
+        std::string name = entry.substr(0, eq);
+        if (std::find(FORWARDED_ENV.begin(), FORWARDED_ENV.end(), name) == FORWARDED_ENV.end()) continue;
+        setenv(name.c_str(), entry.substr(eq + 1).c_str(), 1);
+    }
+    return saved;
+}
+
+static void restoreEnv(std::vector<SavedEnv> saved) {
+    for (SavedEnv entry : saved) {
+        if (entry.isSet) setenv(entry.name.c_str(), entry.value.c_str(), 1);
+        else unsetenv(entry.name.c_str());
+    }
+}
+
+// Runs a single job with its stdout and stderr sent to the two capture files
+// Jobs run one at a time, since they share the process' working directory,
+// environment and output
+int runJob(std::string cwd, std::vector<std::string> env, std::vector<std::string> args, FILE *out, FILE *err) {
+    if (isRunningJob(args)) {
+        fprintf(err, "Error: --run and --bench can't be used through the compile server; use tlc.\n");
+        return 1;
+    }
+    
+    // The way back is held open, so it works even if the directory is renamed
+    int serverCwd = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (serverCwd < 0) {
+        fprintf(err, "Error: The server is unable to open its own directory.\n");
+        return 1;
+    }
+    if (chdir(cwd.c_str()) != 0) {
+        fprintf(err, "Error: Unable to enter directory: %s\n", cwd.c_str());
+        close(serverCwd);
+        return 1;
+    }
+    std::vector<SavedEnv> savedEnv = setJobEnv(env);
+    
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(stdout);
+    fflush(stderr);
+    
+    int savedOut = dup(STDOUT_FILENO);
+    int savedErr = dup(STDERR_FILENO);
+    dup2(fileno(out), STDOUT_FILENO);
+    dup2(fileno(err), STDERR_FILENO);
+    
+    // Whatever goes wrong in one job must not take the server (and every other
+    // client) down with it
+    int code = 1;
+    try {
+        code = runDriver(args);
+    } catch (std::exception &e) {
+        std::cerr << "Error: Internal compiler error: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "Error: Internal compiler error." << std::endl;
+    }
+    
+    std::cout.flush();
+    std::cerr.flush();
+    llvm::outs().flush();
+    llvm::errs().flush();
+    fflush(stdout);
+    fflush(stderr);
+    
+    dup2(savedOut, STDOUT_FILENO);
+    dup2(savedErr, STDERR_FILENO);
+    close(savedOut);
+    close(savedErr);
+    
+    restoreEnv(savedEnv);
+    if (fchdir(serverCwd) != 0) {
+        std::cerr << "Error: Unable to return to the server's directory; stopping the server." << std::endl;
+        lostCwd = true;
+    }
+    close(serverCwd);
+    return code;
+}
+
+// Sends one captured stream: its size, then its contents
+bool sendCapture(int client, FILE *capture) {
+    uint64_t size = ftell(capture);
+    if (!writeAll(client, (char *)&size, sizeof(size))) return false;
+    
+    rewind(capture);
+    char buffer[4096];
+    size_t count;
+    while (size > 0 && (count = fread(buffer, 1, sizeof(buffer), capture)) > 0) {
+        if (count > size) count = size;
+        if (!writeAll(client, buffer, count)) return false;
+        size -= count;
+    }
+    return true;
+}
+
+// Reads a request off the connection, runs it, and sends back the result
+void handleConnection(int client) {
+    std::string cwd = "";
+    std::vector<std::string> env, args;
+    if (!readRequest(client, cwd, env, args)) return;
+    
+    FILE *out = tmpfile();
+    FILE *err = tmpfile();
+    if (out == nullptr || err == nullptr) {
+        if (out) fclose(out);
+        if (err) fclose(err);
+        return;
+    }
+    
+    int32_t code = runJob(cwd, env, args, out, err);
+    fseek(out, 0, SEEK_END);
+    fseek(err, 0, SEEK_END);
+    
+    if (writeAll(client, (char *)&code, sizeof(code)) && sendCapture(client, out)) {
+        sendCapture(client, err);
+    }
+    
+    fclose(out);
+    fclose(err);
+}
+
+int runServer(std::string socketPath) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    
+    if (socketPath.length() >= sizeof(addr.sun_path)) {
+        std::cerr << "Error: Socket path is too long." << std::endl;
+        return 1;
+    }
+    strcpy(addr.sun_path, socketPath.c_str());
+    
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0) {
+        std::cerr << "Error: Unable to create socket." << std::endl;
+        return 1;
+    }
+    
+    unlink(socketPath.c_str());
+    if (bind(server, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(server, 16) != 0) {
+        std::cerr << "Error: Unable to listen on " << socketPath << std::endl;
+        close(server);
+        return 1;
+    }
+    
+    // A client going away mid-reply should not take the server with it
+    signal(SIGPIPE, SIG_IGN);
+    
+    std::cout << "Listening on " << socketPath << std::endl;
+    
+    while (true) {
+        int client = accept(server, nullptr, nullptr);
+        if (client < 0) continue;
+        
+        timeval timeout;
+        timeout.tv_sec = CLIENT_TIMEOUT;
+        timeout.tv_usec = 0;
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        
+        handleConnection(client);
+        close(client);
+        if (lostCwd) break;
+        
+        // Nothing is running now, so nothing holds a symbol but the caches
+        if (Symbol::getCount() > SYMBOL_LIMIT) {
+            clearHeaderCache();
+            AstBuilder::resetTypes();
+            Symbol::reset();
+        }
+    }
+    
+    close(server);
+    unlink(socketPath.c_str());
+    return lostCwd ? 1 : 0;
+}
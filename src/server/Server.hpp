@@ -0,0 +1,44 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+#pragma once
+
+#include <string>
+#include <vector>
+
+//
+// The compile server keeps one tlc process (and all the LLVM setup) alive, and
+// takes jobs from the tlcc client over a Unix socket.
+//
+// A request is the client's working directory, the client's values of the
+// environment variables a job reads (as NAME=value), and its arguments. Strings
+// are sent as a 4-byte size and their bytes, and lists as a 4-byte count and
+// their strings. The reply is the 4-byte exit code, then what the job wrote to
+// stdout, then what it wrote to stderr, each as an 8-byte size followed by that
+// many bytes.
+//
+// A request bigger than 1 MiB is refused, and so is a client that goes quiet
+// for 10 seconds, so one bad client can't hold up or take down the others.
+//
+// The job runs inside the server, so it can't run the program it built; --run
+// and --bench are refused.
+//
+
+// The environment variables a job reads, which the client sends along
+extern const std::vector<std::string> FORWARDED_ENV;
+
+// Returns the socket path, either from $TLC_SERVER or /tmp/tlc-<uid>.sock
+std::string getServerSocketPath();
+
+// Runs the server; only returns if the socket cannot be set up, or if a job
+// leaves it unable to get back to its own working directory
+int runServer(std::string socketPath);
+
+// Protocol helpers (Protocol.cpp)
+bool writeAll(int fd, const char *data, size_t size);
+bool readAll(int fd, char *data, size_t size);
+bool copyStream(int from, int to);
+bool writeRequest(int fd, std::string cwd, std::vector<std::string> env, std::vector<std::string> args);
+bool readRequest(int fd, std::string &cwd, std::vector<std::string> &env, std::vector<std::string> &args);
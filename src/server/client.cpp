@@ -0,0 +1,67 @@
+//
+// Copyright 2021-2022 Patrick Flynn
+// This file is part of the Tiny Lang compiler.
+// Tiny Lang is licensed under the BSD-3 license. See the COPYING file for more information.
+//
+// tlcc: the thin client for the compile server
+// It takes the same arguments as tlc, and hands them to a running "tlc --server"
+//
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <server/Server.hpp>
+
+int main(int argc, char **argv) {
+    std::vector<std::string> args;
+    for (int i = 1; i<argc; i++) args.push_back(argv[i]);
+    
+    char cwd[4096];
+    if (getcwd(cwd, sizeof(cwd)) == nullptr) {
+        std::cerr << "Error: Unable to get the working directory." << std::endl;
+        return 1;
+    }
+    
+    // The job should see our environment, not the server's
+    std::vector<std::string> env;
+    for (std::string name : FORWARDED_ENV) {
+        const char *value = getenv(name.c_str());
+        if (value != nullptr) env.push_back(name + "=" + value);
+    }
+    
+    std::string socketPath = getServerSocketPath();
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0 || connect(server, (sockaddr *)&addr, sizeof(addr)) != 0) {
+        std::cerr << "Error: No compile server at " << socketPath << " (start one with tlc --server)." << std::endl;
+        return 1;
+    }
+    
+    if (!writeRequest(server, cwd, env, args)) {
+        std::cerr << "Error: Unable to send the job to the server." << std::endl;
+        return 1;
+    }
+    
+    int32_t code = 1;
+    if (!readAll(server, (char *)&code, sizeof(code))) {
+        std::cerr << "Error: The server closed the connection." << std::endl;
+        return 1;
+    }
+    
+    // Then the job's stdout and stderr, which go to ours
+    if (!copyStream(server, STDOUT_FILENO) || !copyStream(server, STDERR_FILENO)) {
+        std::cerr << "Error: The server closed the connection." << std::endl;
+        close(server);
+        return 1;
+    }
+    
+    close(server);
+    return code;
+}
@@ -42,8 +42,6 @@ function run_test() {
     	fi
     	
     	rm ./$name
-    	rm /tmp/$name.o
-    	rm /tmp/$name.asm
     	rm /tmp/$name.actual
     	rm /tmp/$name.exp
     	
@@ -55,6 +53,45 @@ function run_test() {
     done
 }
 
+# Each of these programs has to fail to compile. The compiler's messages are
+# compared with out/<name>.out, and its exit code with out/<name>.code.
+function run_error_test() {
+    for entry in $1/*.tl
+    do
+    	name=`basename $entry .tl`
+    	
+    	echo ""
+    	echo $name
+    	
+    	$TLC $entry -o $name > /tmp/$name.actual 2>&1
+    	CODE=$?
+    	
+    	if [[ -f ./$name ]] ; then
+    	    rm ./$name
+    	    echo "Fail: Compiled"
+    	    exit 1
+    	fi
+    	
+    	diff -wB /tmp/$name.actual $1/out/$name.out
+    	if [[ $? != 0 ]] ; then
+    	    echo "Fail: Output"
+    	    exit 1
+    	fi
+    	
+    	echo $CODE > /tmp/$name.actual
+    	diff -wB /tmp/$name.actual $1/out/$name.code
+    	if [[ $? != 0 ]] ; then
+    	    echo "Fail: Code"
+    	    exit 1
+    	fi
+    	
+    	echo "Pass"
+    	rm /tmp/$name.actual
+    	
+    	test_count=$((test_count+1))
+    done
+}
+
 flags=""
 
 echo "Running all tests..."
@@ -68,6 +105,14 @@ run_test 'test/array'
 run_test 'test/func'
 run_test 'test/str'
 run_test 'test/struct'
+run_test 'test/scope'
+
+run_error_test 'test/syntax/error'
+run_error_test 'test/scope/error'
+run_error_test 'test/struct/error'
+
+echo ""
+bash test/driver.sh $TLC || exit 1
 
 echo ""
 echo "$test_count tests passed successfully."
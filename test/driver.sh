@@ -0,0 +1,96 @@
+#!/bin/bash
+
+# Tests the driver: separate compilation, linking objects, parallel builds,
+# the object cache, dependency files, --run and the compile server. Run with
+# the path to tlc.
+
+TLC=`realpath ${1:-build/src/tlc}`
+SRC=`realpath test/driver`
+WORK=`mktemp -d`
+TLCC=`dirname $TLC`/tlcc
+SERVER_PID=""
+test_count=0
+
+function fail() {
+    echo "Fail: $1"
+    [[ $SERVER_PID != "" ]] && kill $SERVER_PID
+    rm -rf $WORK
+    exit 1
+}
+
+# Runs the program and checks what it printed
+function check_run() {
+    OUTPUT=`$1`
+    if [[ "$OUTPUT" != "Sum: 5" ]] ; then
+        fail "$2: expected \"Sum: 5\", got \"$OUTPUT\""
+    fi
+    test_count=$((test_count+1))
+}
+
+cd $WORK
+
+# -c writes an object for each unit, and the objects link together
+$TLC -c $SRC/main.tl -o main.o || fail "-c main.tl"
+$TLC -c $SRC/util.tl || fail "-c util.tl"
+[[ -f main.o && -f util.o ]] || fail "-c did not write the objects"
+$TLC main.o util.o -o linked > /dev/null 2>&1 || fail "linking objects"
+check_run ./linked "multi-object link"
+
+# -j builds the units on several threads
+$TLC -j2 $SRC/main.tl $SRC/util.tl -o parallel > /dev/null 2>&1 || fail "-j2"
+check_run ./parallel "-j2"
+
+# The second build finds both units in the cache, so nothing is parsed
+$TLC --cache-dir=$WORK/cache -ftime-report $SRC/main.tl $SRC/util.tl -o cached 2> first.txt > /dev/null
+grep -q "Cache store" first.txt || fail "the first build did not store in the cache"
+rm cached
+$TLC --cache-dir=$WORK/cache -ftime-report $SRC/main.tl $SRC/util.tl -o cached 2> second.txt > /dev/null
+grep -q "Cache lookup" second.txt || fail "the second build did not look in the cache"
+grep -qE "^  (Parse|Cache store) " second.txt && fail "the second build missed the cache"
+check_run ./cached "cache hit"
+
+# -MD writes the depfile next to the object, and -MF names it
+$TLC -c -MD $SRC/main.tl -o deps.o || fail "-MD"
+grep -q "^deps.o:" deps.d || fail "-MD: the depfile does not name the object"
+grep -q "main.tl" deps.d || fail "-MD: the depfile does not list the source"
+grep -q "std/io.th" deps.d || fail "-MD: the depfile does not list io.th"
+test_count=$((test_count+1))
+
+$TLC -c -MF named.d $SRC/util.tl -o util2.o || fail "-MF"
+grep -q "^util2.o:" named.d || fail "-MF: the depfile does not name the object"
+grep -q "io.th" named.d && fail "-MF: the depfile lists a header util.tl doesn't import"
+test_count=$((test_count+1))
+
+# --run executes the program in process, and passes what follows -- to main
+OUTPUT=`$TLC --run $SRC/args.tl -- one two`
+CODE=$?
+[[ "$OUTPUT" == $'Arg: one\nArg: two' ]] || fail "--run: expected the two arguments, got \"$OUTPUT\""
+[[ $CODE == 2 ]] || fail "--run: expected exit code 2, got $CODE"
+test_count=$((test_count+1))
+
+# A compile server on a private socket builds through tlcc like tlc does, and
+# stays up for the next job after one that fails
+export TLC_SERVER=$WORK/server.sock
+$TLC --server > server.txt 2>&1 &
+SERVER_PID=$!
+for i in `seq 50` ; do
+    [[ -S $TLC_SERVER ]] && break
+    sleep 0.1
+done
+[[ -S $TLC_SERVER ]] || fail "the compile server did not start"
+
+$TLCC $SRC/main.tl $SRC/util.tl -o served > /dev/null 2>&1 || fail "tlcc"
+check_run ./served "tlcc"
+
+$TLCC $SRC/main.tl -o broken > /dev/null 2>&1 && fail "tlcc: a unit with a missing function linked"
+rm -f served
+$TLCC $SRC/main.tl $SRC/util.tl -o served > /dev/null 2>&1 || fail "tlcc after a failed job"
+check_run ./served "tlcc after a failed job"
+
+kill $SERVER_PID
+wait $SERVER_PID 2> /dev/null
+SERVER_PID=""
+unset TLC_SERVER
+
+rm -rf $WORK
+echo "$test_count driver tests passed."